@@ -26,40 +26,67 @@
 #define YAPT_VEC3_H
 
 #include "constants.h"
+#include <cmath>
 #include <iostream>
 #include "utils.h"
 
 class Vec3 {
 public:
+#ifdef YAPT_VEC3_PADDED
+    // the unused fourth lane keeps the components in one aligned 256 bits register
+    alignas(4 * sizeof(double)) double e[4];
+#else
     double e[3];
+#endif
 
-    Vec3();
+    constexpr Vec3() : e{0, 0, 0} {}
 
-    Vec3(double x, double y, double z);
+    constexpr Vec3(const double x, const double y, const double z) : e{x, y, z} {}
 
-    [[nodiscard]] double x() const;
+    [[nodiscard]] constexpr double x() const { return e[0]; }
 
-    [[nodiscard]] double y() const;
+    [[nodiscard]] constexpr double y() const { return e[1]; }
 
-    [[nodiscard]] double z() const;
+    [[nodiscard]] constexpr double z() const { return e[2]; }
 
-    Vec3 operator-() const;
+    constexpr Vec3 operator-() const { return {-e[0], -e[1], -e[2]}; }
 
-    double operator[](int i) const;
+    constexpr double operator[](const int i) const { return e[i]; }
 
-    double &operator[](int i);
+    constexpr double &operator[](const int i) { return e[i]; }
 
-    Vec3 &operator+=(const Vec3 &v);
+    constexpr Vec3 &operator+=(const Vec3 &v) {
+        e[0] += v.e[0];
+        e[1] += v.e[1];
+        e[2] += v.e[2];
+        return *this;
+    }
 
-    Vec3 &operator*=(double t);
+    constexpr Vec3 &operator*=(const double t) {
+        e[0] *= t;
+        e[1] *= t;
+        e[2] *= t;
+        return *this;
+    }
 
-    Vec3 &operator/=(double t);
+    constexpr Vec3 &operator/=(const double t) {
+        e[0] /= t;
+        e[1] /= t;
+        e[2] /= t;
+        return *this;
+    }
 
-    [[nodiscard]] double length2() const;
+    [[nodiscard]] constexpr double length2() const {
+        return e[0] * e[0] + e[1] * e[1] + e[2] * e[2];
+    }
 
-    [[nodiscard]] double length() const;
+    [[nodiscard]] double length() const {
+        return std::sqrt(length2());
+    }
 
-    [[nodiscard]] bool near_zero() const;
+    [[nodiscard]] bool near_zero() const {
+        return (std::fabs(e[0]) < EPSILON) && (std::fabs(e[1]) < EPSILON) && (std::fabs(e[2]) < EPSILON);
+    }
 
 
     inline static Vec3 random() {
@@ -79,35 +106,35 @@ inline std::ostream &operator<<(std::ostream &out, const Vec3 &v) {
     return out << v.e[0] << ' ' << v.e[1] << ' ' << v.e[2];
 }
 
-inline Vec3 operator+(const Vec3 &u, const Vec3 &v) {
+constexpr Vec3 operator+(const Vec3 &u, const Vec3 &v) {
     return {u.e[0] + v.e[0], u.e[1] + v.e[1], u.e[2] + v.e[2]};
 }
 
-inline Vec3 operator-(const Vec3 &u, const Vec3 &v) {
+constexpr Vec3 operator-(const Vec3 &u, const Vec3 &v) {
     return {u.e[0] - v.e[0], u.e[1] - v.e[1], u.e[2] - v.e[2]};
 }
 
-inline Vec3 operator*(const Vec3 &u, const Vec3 &v) {
+constexpr Vec3 operator*(const Vec3 &u, const Vec3 &v) {
     return {u.e[0] * v.e[0], u.e[1] * v.e[1], u.e[2] * v.e[2]};
 }
 
-inline Vec3 operator*(double t, const Vec3 &v) {
+constexpr Vec3 operator*(double t, const Vec3 &v) {
     return {t * v.e[0], t * v[1], t * v[2]};
 }
 
-inline Vec3 operator*(const Vec3 &v, double t) {
+constexpr Vec3 operator*(const Vec3 &v, double t) {
     return t * v;
 }
 
-inline Vec3 operator/(const Vec3 &v, double t) {
+constexpr Vec3 operator/(const Vec3 &v, double t) {
     return {v.e[0] / t, v.e[1] / t, v.e[2] / t};
 }
 
-inline double dot(const Vec3 &u, const Vec3 &v) {
+constexpr double dot(const Vec3 &u, const Vec3 &v) {
     return u.e[0] * v.e[0] + u.e[1] * v.e[1] + u.e[2] * v.e[2];
 }
 
-inline Vec3 cross(const Vec3 &u, const Vec3 &v) {
+constexpr Vec3 cross(const Vec3 &u, const Vec3 &v) {
     return {u.e[1] * v.e[2] - u.e[2] * v.e[1],
             u.e[2] * v.e[0] - u.e[0] * v.e[2],
             u.e[0] * v.e[1] - u.e[1] * v.e[0]};
@@ -137,7 +164,7 @@ inline Vec3 random_on_hemisphere(const Vec3 &normal) {
         return -on_unit_sphere;
 }
 
-inline bool is_null(const Vec3 &v) {
+constexpr bool is_null(const Vec3 &v) {
     return v.e[0] == 0 && v.e[1] == 0 && v.e[2] == 0;
 }
 
@@ -149,6 +176,10 @@ inline bool are_epsilon_equal(const Vec3 &v, const Vec3 &w) {
     return (v - w).length2() < EPSILON;
 }
 
+inline bool Vec3::operator==(const Vec3& other) const {
+    return are_epsilon_equal(*this, other);
+}
+
 inline Vec3 reflect(const Vec3 &v, const Vec3 &n) {
     return v - 2 * dot(v, n) * n;
 }
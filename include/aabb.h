@@ -111,6 +111,34 @@ private:
     }
 };
 
+/**
+ * A bounding box stored in the `real` precision, for acceleration structures. The bounds are rounded outward so
+ * the box always contains the box it was built from, and hits are tested in double: a ray hitting the original box
+ * always hits the compact one.
+ */
+class CompactAABB {
+public:
+    CompactAABB() = default;
+
+    explicit CompactAABB(const AABB &box);
+
+    /**
+     * @return the box in double precision, containing the box this one was built from
+     */
+    [[nodiscard]] AABB to_aabb() const;
+
+    /**
+     * @return the bounds along an axis, widened to double
+     */
+    [[nodiscard]] Interval axis_interval(const int n) const { return {lower[n], upper[n]}; }
+
+    [[nodiscard]] bool hit(const Ray &r, Interval ray_t) const;
+
+private:
+    real lower[3] = {0, 0, 0};
+    real upper[3] = {0, 0, 0};
+};
+
 AABB operator+(const AABB &bbox, const Vec3 &offset);
 
 AABB operator+(const Vec3 &offset, const AABB &bbox);
@@ -4,6 +4,7 @@
 #include "Vec3.h"
 #include "color.h"
 #include "sampler.h"
+#include "arena.h"
 #include <memory>
 #include <vector>
 #include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
@@ -25,13 +26,30 @@ typedef Voronoi::Face_handle Face_handle;
 typedef Voronoi::Ccb_halfedge_circulator Ccb_halfedge_circulator;
 typedef CGAL::Polygon_2<K> Polygon;
 
+/**
+ * First hits of the samples of a pixel, summed by the cameras while they trace them, for the albedo, normal and
+ * depth layers
+ */
+struct FirstHits {
+    Color albedo;
+    Color normal;
+    double depth = 0.;
+
+    FirstHits &operator+=(const FirstHits &other) {
+        albedo += other.albedo;
+        normal += other.normal;
+        depth += other.depth;
+        return *this;
+    }
+};
+
 class SampleAggregator {
 public:
     virtual ~SampleAggregator() = default;
     virtual Color aggregate() = 0;
     virtual void sample_from(std::shared_ptr<SamplerFactory>, double x, double y) = 0;
     virtual void insert_contribution(Color color);
-    using const_iterator = std::vector<Sample>::const_iterator;
+    using const_iterator = std::pmr::vector<Sample>::const_iterator;
 
     const_iterator begin() const {
         return _samples.begin();
@@ -41,8 +59,10 @@ public:
         return _samples.begin() + _usable_sample_count;
     }
 
-    std::vector<Sample> _samples;
-    std::vector<Color> contributions;
+    // allocated from the per pixel arena when the aggregator is created in a PixelArena::Scope
+    std::pmr::vector<Sample> _samples{PixelArena::resource()};
+    std::pmr::vector<Color> contributions{PixelArena::resource()};
+    FirstHits firstHits;
 
 protected:
     std::size_t _usable_sample_count = 0;
@@ -98,7 +118,7 @@ public:
 
     Voronoi voronoi;
     Delaunay delaunay;
-    std::vector<double> weights;
+    std::pmr::vector<double> weights{PixelArena::resource()};
 
 protected:
     double compute_voronoi_cell_area(Face_handle face) const;
@@ -137,6 +157,17 @@ public:
     virtual ~AggregatorFactory() = default;
 
     virtual std::shared_ptr<SampleAggregator> create() = 0;
+
+    /**
+     * Whether the aggregators gain from being prepared together: the cameras then gather a whole line before
+     * aggregating any of its pixels
+     */
+    [[nodiscard]] virtual bool batched() const { return false; }
+
+    /**
+     * Called from the render threads with gathered pixels created by this factory, before they are aggregated
+     */
+    virtual void prepare(const std::vector<std::shared_ptr<SampleAggregator>> &aggregators) {}
 };
 
 class MCAggregatorFactory: public AggregatorFactory {
@@ -0,0 +1,69 @@
+/*
+ * This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
+ * Copyright (c) 2025 PrISE-3D.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * --- ADDITIONAL PERMISSION UNDER GNU GPL VERSION 3 SECTION 7 ---
+ *
+ * If you modify this Program, or any covered work, by linking or
+ * combining it with the Intel Math Kernel Library (MKL) (or a modified
+ * version of that library), containing parts covered by the terms of
+ * the Intel Simplified Software License, the licensors of this
+ * Program grant you additional permission to convey the resulting work.
+ */
+
+#ifndef YAPT_ARENA_H
+#define YAPT_ARENA_H
+
+#include <memory>
+#include <memory_resource>
+
+/**
+ * Per thread bump arena for the transient data of a pixel: its aggregator, pixel sampler, samples and contributions.
+ * Inside a PixelArena::Scope these are allocated from the arena of the rendering thread, and all released at once
+ * when the scope ends; outside they come from the default memory resource.
+ */
+class PixelArena {
+public:
+    /**
+     * @return the resource per pixel data is allocated from on the current thread
+     */
+    static std::pmr::memory_resource *resource();
+
+    /**
+     * Routes the per pixel allocations of the current thread to its arena while alive.
+     * Nothing allocated in a scope may outlive it: callers keeping an aggregator must not open one.
+     */
+    class Scope {
+    public:
+        Scope();
+        ~Scope();
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        bool nested;
+    };
+};
+
+/**
+ * Allocates a T from the per pixel resource of the current thread
+ */
+template<typename T, typename... Args>
+std::shared_ptr<T> make_pixel_shared(Args &&... args) {
+    return std::allocate_shared<T>(std::pmr::polymorphic_allocator<T>(PixelArena::resource()),
+                                   std::forward<Args>(args)...);
+}
+
+#endif //YAPT_ARENA_H
@@ -6,6 +6,7 @@
 #include "aabb.h"
 #include "hittable.h"
 #include "hittable_list.h"
+#include "ray_packet.h"
 
 #include <algorithm>
 
@@ -20,11 +21,12 @@ public:
 
     BVHNode(std::vector<shared_ptr<Hittable>> &objects, size_t start, size_t end) {
         // Build the bounding box of the span of source objects.
-        bbox = AABB::empty;
+        AABB box = AABB::empty;
         for (size_t object_index = start; object_index < end; object_index++)
-            bbox = AABB(bbox, objects[object_index]->bounding_box());
+            box = AABB(box, objects[object_index]->bounding_box());
+        bbox = CompactAABB(box);
 
-        int axis = bbox.longest_axis();
+        axis = box.longest_axis();
 
         auto comparator = (axis == 0) ? box_x_compare
                                       : (axis == 1) ? box_y_compare
@@ -35,8 +37,9 @@ public:
         if (object_span == 1) {
             left = right = objects[start];
         } else if (object_span == 2) {
-            left = objects[start];
-            right = objects[start + 1];
+            const bool swap = comparator(objects[start + 1], objects[start]);
+            left = objects[swap ? start + 1 : start];
+            right = objects[swap ? start : start + 1];
         } else {
             std::sort(objects.begin() + start, objects.begin() + end, comparator);
 
@@ -56,12 +59,29 @@ public:
         return hit_left || hit_right;
     }
 
-    [[nodiscard]] AABB bounding_box() const override { return bbox; }
+    uint32_t hit_packet(RayPacket &packet, const Interval ray_t) const override {
+        if (!packet.may_hit(bbox, ray_t))
+            return 0;
+
+        // single object nodes share their child
+        if (right == left)
+            return left->hit_packet(packet, ray_t);
+
+        // children are sorted along the split axis: the nearer one first, so that its hits cull the farther one
+        const bool backward = packet.backward(axis);
+        const uint32_t hit_near = (backward ? right : left)->hit_packet(packet, ray_t);
+        const uint32_t hit_far = (backward ? left : right)->hit_packet(packet, ray_t);
+
+        return hit_near | hit_far;
+    }
+
+    [[nodiscard]] AABB bounding_box() const override { return bbox.to_aabb(); }
 
 private:
     shared_ptr<Hittable> left;
     shared_ptr<Hittable> right;
-    AABB bbox;
+    CompactAABB bbox;
+    int axis;  // axis along which the children are sorted
 
     static bool box_compare(
             const shared_ptr<Hittable> &a, const shared_ptr<Hittable> &b, int axis_index
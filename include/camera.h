@@ -13,6 +13,19 @@
 #endif
 
 #include "path.h"
+#include "sample_dump.h"
+
+#include <atomic>
+#include <functional>
+
+/**
+ * Combines a seed and pixel coordinates into a per pixel seed
+ */
+inline uint64_t combine(const uint32_t seed, const uint32_t x, const uint32_t y) {
+    auto combined = static_cast<uint64_t>(seed);
+    combined = (combined << 32) | ((static_cast<uint64_t>(x & 0xFFFF) << 16) | (y & 0xFFFF));
+    return combined;
+}
 
 class Camera {
 public:
@@ -38,11 +51,56 @@ public:
     long seed = 0;
     shared_ptr<SamplingStrategy> samplingStrategy;
 
+    /**
+     * When set, the parallel cameras stream the finished lines to this sink instead of keeping the image in memory
+     */
+    shared_ptr<TileSink> tileSink;
+
+    /**
+     * Extra layers rendered with the beauty image, among albedo, normal, depth (first hits averaged over the pixel
+     * samples), variance (of the Monte Carlo estimate), count (usable samples) and mc (Monte Carlo estimate, next
+     * to the configured aggregator). Streamed images have no extra layers.
+     */
+    std::vector<std::string> aovs;
+
+    /**
+     * When set, the samples, contributions and weights of the selected pixels are dumped once gathered
+     */
+    shared_ptr<SampleDump> sampleDump;
+
+    /**
+     * Stops the cameras at the next line or batch of lines: the image is left partially rendered
+     */
+    std::atomic<bool> cancelled{false};
+
+    /**
+     * Called by the render threads whenever lines [first_row, first_row + rows) of the image are complete
+     */
+    std::function<void(size_t first_row, size_t rows)> onLinesRendered;
+
+    /**
+     * Called by render once the camera is initialized and its sampling strategy trained, before the first line:
+     * until then the camera and the strategy must not be read by other threads
+     */
+    std::function<void()> onPrepared;
+
     virtual void render(const Hittable &world, const Hittable &lights) = 0;
-    shared_ptr<ImageData> data() {return make_shared<ImageData>(imageData);}
+    /**
+     * The framebuffer of the camera, shared rather than copied
+     */
+    shared_ptr<ImageData> data() {return imageData;}
     virtual std::shared_ptr<SampleAggregator> render_pixel(const Hittable &world, const Hittable &lights, size_t row,
                                                           size_t column) = 0;
 
+    /**
+     * Samples a pixel and gathers its contributions without writing the image, so that independent replicas of a
+     * pixel may run concurrently. The aggregator is returned before aggregation.
+     * @param seed replaces the camera seed for this pixel
+     */
+    [[nodiscard]] virtual std::shared_ptr<SampleAggregator> sample_pixel(const Hittable &world, const Hittable &lights,
+                                                                        size_t row, size_t column,
+                                                                        uint32_t seed) const = 0;
+
     virtual void initialize();
 
 protected:
@@ -53,7 +111,7 @@ protected:
     Vec3 u, v, w;            // Camera frame basis vectors
     Vec3 defocusDiskU;       // Defocus disk horizontal radius
     Vec3 defocusDiskV;       // Defocus disk vertical radius
-    ImageData imageData = ImageData();     // image output
+    shared_ptr<ImageData> imageData = make_shared<ImageData>();     // image output
 
 
     [[nodiscard]] Point3 defocusDiskSample() const;
@@ -68,12 +126,60 @@ public:
     virtual void render_line(const Hittable &world, const Hittable &lights, size_t j);
     void persist_color_to_data(size_t row, size_t column, Color pixel_color);
 
+    /**
+     * Fills the extra layers of the framebuffer for a sampled and gathered pixel
+     */
+    void persist_aovs(size_t row, size_t column, const SampleAggregator &aggregator);
+
     virtual std::shared_ptr<SampleAggregator> render_pixel(const Hittable &world, const Hittable &lights, size_t row,
                                                           size_t column) override;
 
+    [[nodiscard]] std::shared_ptr<SampleAggregator> sample_pixel(const Hittable &world, const Hittable &lights,
+                                                                size_t row, size_t column,
+                                                                uint32_t seed) const override;
+
+    /**
+     * Number of primary rays traced together as a packet (at most RayPacket::capacity), 1 traces them one by one
+     */
+    size_t packetSize = 1;
+
 protected:
+    /**
+     * Aggregates a gathered pixel, then writes its color, its AOVs and its dump record
+     */
+    void persist_pixel(size_t row, size_t column, SampleAggregator &aggregator);
+
+    /**
+     * Whether the image has layers made of the first hits of the samples (albedo, normal or depth)
+     */
+    [[nodiscard]] bool records_first_hits() const;
+
+    /**
+     * Adds the finalized first hit of a primary ray to the sums of its pixel
+     */
+    static void record_first_hit(FirstHits &hits, const Ray &r, const HitRecord &rec);
+
+    /**
+     * Renders the training passes of the sampling strategy, if any: rays through random positions of the pixels,
+     * whose light is only used by the strategy to learn the scene
+     */
+    void train(const Hittable &world, const Hittable &lights);
 
     [[nodiscard]] virtual Color rayColor(const Ray &r, int depth, const Hittable &world, const Hittable &lights) const;
+
+    /**
+     * Gathers the light along a ray, reporting its first hit
+     * @param rec the first hit of the ray, left untouched if the ray escapes the scene
+     */
+    [[nodiscard]] Color rayColor(const Ray &r, int depth, const Hittable &world, const Hittable &lights,
+                                 HitRecord &rec) const;
+
+    /**
+     * Gathers the light along a ray from its known first hit
+     * @param rec the first hit of the ray, finalized here
+     */
+    [[nodiscard]] virtual Color shade(const Ray &r, int depth, const Hittable &world, const Hittable &lights,
+                                      HitRecord &rec) const;
 };
 
 class ForwardParallelCamera: public ForwardCamera {
@@ -84,8 +190,9 @@ public:
 
 class BiasedForwardParallelCamera: public ForwardParallelCamera {
 public:
-    std::shared_ptr<SampleAggregator> render_pixel(const Hittable &world, const Hittable &lights, size_t row,
-                                                  size_t column) override;
+    [[nodiscard]] std::shared_ptr<SampleAggregator> sample_pixel(const Hittable &world, const Hittable &lights,
+                                                                size_t row, size_t column,
+                                                                uint32_t seed) const override;
 };
 
 class TestCamera final : public ForwardParallelCamera {
@@ -93,18 +200,22 @@ class TestCamera final : public ForwardParallelCamera {
     [[nodiscard]] Color rayColor(const Ray &r, int depth, const Hittable &world, const Hittable &lights) const override;
 };
 
-class CartographyCamera final : public ForwardCamera {
+/**
+ * Maps the integrand of one pixel: cell (row, column) of the image holds the radiance at the matching sub-position
+ * of the pixel (pixel_x, pixel_y). Lines of the map are rendered in parallel.
+ */
+class CartographyCamera final : public ForwardParallelCamera {
 public:
     size_t pixel_x;
     size_t pixel_y;
 
     CartographyCamera(size_t pixel_x, size_t pixel_y);
-    void render(const Hittable &world, const Hittable &lights) override;
+    /**
+     * Renders the cells of a line one by one: cells trace a single ray, there is nothing to aggregate or batch
+     */
+    void render_line(const Hittable &world, const Hittable &lights, size_t j) override;
     std::shared_ptr<SampleAggregator> render_pixel(const Hittable &world, const Hittable &lights, size_t row,
                                                   size_t column) override;
-
-    void initialize() override;
-
 };
 
 class FunctionCamera final : public ForwardParallelCamera {
@@ -112,7 +223,9 @@ class FunctionCamera final : public ForwardParallelCamera {
 #ifdef FUNCTION_PARSING
     FunctionCamera(shared_ptr<Function> function);
 #endif
-    std::shared_ptr<SampleAggregator> render_pixel(const Hittable &world, const Hittable &lights, size_t row, size_t column) override;
+    [[nodiscard]] std::shared_ptr<SampleAggregator> sample_pixel(const Hittable &world, const Hittable &lights,
+                                                                size_t row, size_t column,
+                                                                uint32_t seed) const override;
 
 
 protected:
@@ -122,7 +235,7 @@ protected:
 };
 
 class NormalCamera : public ForwardParallelCamera {
-    Color rayColor(const Ray &r, int depth, const Hittable &world, const Hittable &lights) const override;
+    Color shade(const Ray &r, int depth, const Hittable &world, const Hittable &lights, HitRecord &rec) const override;
 };
 
 class SinglePixelCamera: public ForwardCamera {
@@ -11,12 +11,12 @@ class ConstantMedium : public Hittable {
 public:
     ConstantMedium(shared_ptr<Hittable> boundary, double density, shared_ptr<Texture> tex)
             : boundary(boundary), neg_inv_density(-1/density),
-              phase_function(make_shared<Isotropic>(tex))
+              phase_function(make_shared<Isotropic>(tex)), phase_function_id(MaterialTable::add(phase_function))
     {}
 
     ConstantMedium(shared_ptr<Hittable> boundary, double density, const Color& albedo)
             : boundary(boundary), neg_inv_density(-1/density),
-              phase_function(make_shared<Isotropic>(albedo))
+              phase_function(make_shared<Isotropic>(albedo)), phase_function_id(MaterialTable::add(phase_function))
     {}
 
     bool hit(const Ray& r, Interval ray_t, HitRecord& rec) const override {
@@ -51,7 +51,9 @@ public:
         rec.normal = Vec3(1, 0, 0);  // arbitrary
         rec.front_face = true;     // also arbitrary
 
-        rec.mat = phase_function;
+        rec.mat_id = phase_function_id;
+        rec.light_id = light_id;
+        rec.deferred = nullptr;
 
         return true;
     }
@@ -62,6 +64,7 @@ private:
     shared_ptr<Hittable> boundary;
     double neg_inv_density;
     shared_ptr<Material> phase_function;
+    uint32_t phase_function_id;
 };
 
 #endif //YAPT_CONSTANT_MEDIUM_H
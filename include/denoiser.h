@@ -0,0 +1,71 @@
+/*
+ * This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
+ * Copyright (c) 2025 PrISE-3D.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * --- ADDITIONAL PERMISSION UNDER GNU GPL VERSION 3 SECTION 7 ---
+ *
+ * If you modify this Program, or any covered work, by linking or
+ * combining it with the Intel Math Kernel Library (MKL) (or a modified
+ * version of that library), containing parts covered by the terms of
+ * the Intel Simplified Software License, the licensors of this
+ * Program grant you additional permission to convey the resulting work.
+ */
+
+#ifndef YAPT_DENOISER_H
+#define YAPT_DENOISER_H
+
+#include <filesystem>
+#include <memory>
+
+struct ImageData;
+
+/**
+ * Post-process stage running a TorchScript denoiser on the CPU. The model receives a float32 tensor of shape
+ * [1, 9, h, w]: the beauty image, then the albedo and normal AOVs, three channels each, and returns the denoised
+ * beauty as [1, 3, h, w]. The image is processed in overlapping tiles so that memory stays bounded on large renders,
+ * only the inner part of each tile is kept.
+ */
+class Denoiser {
+public:
+    /**
+     * Loads the model, throws c10::Error when it cannot be read
+     * @param path TorchScript module (torch.jit.save)
+     * @param numThreads intra-op threads used by the inference, set for the time of denoise only
+     * @param tileSize side of the tiles kept from each inference
+     * @param overlap context added around each tile
+     */
+    explicit Denoiser(const std::filesystem::path &path, int numThreads, std::size_t tileSize = 256,
+                      std::size_t overlap = 32);
+    ~Denoiser();
+
+    Denoiser(const Denoiser &) = delete;
+    Denoiser &operator=(const Denoiser &) = delete;
+
+    /**
+     * Replaces the beauty of the image with its denoised version, the albedo and normal layers are required
+     * @return false when a guide layer is missing or the model output has not the shape of its input tile, the
+     * image is then left untouched. Errors raised by the model are thrown as c10::Error.
+     */
+    bool denoise(ImageData &image) const;
+
+private:
+    struct Model;
+
+    std::unique_ptr<Model> model;
+    int numThreads;
+    std::size_t tileSize;
+    std::size_t overlap;
+};
+
+#endif //YAPT_DENOISER_H
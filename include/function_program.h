@@ -0,0 +1,78 @@
+/*
+ * This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
+ * Copyright (c) 2025 PrISE-3D.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * --- ADDITIONAL PERMISSION UNDER GNU GPL VERSION 3 SECTION 7 ---
+ *
+ * If you modify this Program, or any covered work, by linking or
+ * combining it with the Intel Math Kernel Library (MKL) (or a modified
+ * version of that library), containing parts covered by the terms of
+ * the Intel Simplified Software License, the licensors of this
+ * Program grant you additional permission to convey the resulting work.
+ */
+
+#ifndef YAPT_FUNCTION_PROGRAM_H
+#define YAPT_FUNCTION_PROGRAM_H
+
+#include "yapt.h"
+#include <string>
+#include <vector>
+
+/**
+ * A stack bytecode for the integrands of the .func benchmarks, evaluated a whole batch of points per instruction.
+ * It covers the subset of the exprtk syntax those files use: x, y, numbers, + - * / ^, comparisons, parentheses and
+ * the sin, cos, tan, abs, sqrt, exp, log and frac functions.
+ */
+class FunctionProgram {
+public:
+    /**
+     * Compiles an expression
+     * @param source the expression
+     * @return the program, nullptr if the expression uses something outside the supported subset
+     */
+    static shared_ptr<FunctionProgram> compile(const std::string &source);
+
+    /**
+     * Evaluates the program on n points
+     * @param x abscissas of the points
+     * @param y ordinates of the points
+     * @param out the n values
+     */
+    void evaluate(const double *x, const double *y, double *out, std::size_t n) const;
+
+    /**
+     * Translates the program to a C++ expression of the doubles x and y, computing the same values as evaluate.
+     * Relies on the yapt_frac, yapt_compare and yapt_power helpers declared by NativeFunction.
+     */
+    [[nodiscard]] std::string to_cpp() const;
+
+private:
+    enum class Op {
+        X, Y, Constant,
+        Add, Sub, Mul, Div, Pow, Lt, Le, Gt, Ge,
+        Neg, Sin, Cos, Tan, Abs, Sqrt, Exp, Log, Frac, PowConstant
+    };
+
+    struct Instruction {
+        Op op;
+        double value;  // for Constant and PowConstant
+    };
+
+    std::vector<Instruction> code;
+    std::size_t depth = 0;  // stack size the program needs
+
+    class Parser;
+};
+
+#endif //YAPT_FUNCTION_PROGRAM_H
@@ -28,14 +28,26 @@
 #ifdef FUNCTION_PARSING
 
 #include "yapt.h"
+#include "function_program.h"
+#include "native_function.h"
+#include <atomic>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "exprtk/exprtk.hpp"
 
 class Function {
 public:
 
-    static shared_ptr<Function> from_file(std::string filename) {
+    /**
+     * Reads a function from the first line of a file
+     * @param filename the file
+     * @param native whether batches are evaluated by native code compiled at startup, when possible
+     */
+    static shared_ptr<Function> from_file(std::string filename, const bool native = false) {
         std::ifstream file(filename);
         if (!file.is_open()) {
             std::cerr << "Error opening file " << filename << std::endl;
@@ -46,40 +58,143 @@ public:
         std::string str_fn;
 
         std::getline(file, str_fn);
-        return make_shared<Function>(str_fn);
+        return make_shared<Function>(str_fn, native);
     }
 
-    explicit Function(std::string str_fn) {
+    explicit Function(std::string str_fn, const bool native = false) : source(std::move(str_fn)), id(next_id()) {
         random_seed(100);
-        std::cout << "compiling function " << str_fn << std::endl;
-        symbol_table.add_variable("x", _x);
-        symbol_table.add_variable("y", _y);
-        symbol_table.add_function("RND", rnd_double);
-        symbol_table.add_constants();
+        std::clog << "compiling function " << source << std::endl;
+        local();
 
-        expression.register_symbol_table(symbol_table);
+        program = FunctionProgram::compile(source);
+        if (program && !matches_expression(*program))
+            program = nullptr;
 
-        parser.compile(str_fn, expression);
+        if (native && program) {
+            native_function = NativeFunction::compile(*program);
+            if (native_function && !matches_expression(*native_function))
+                native_function = nullptr;
+        }
+
+        if (native_function)
+            std::clog << "batches evaluated as native code" << std::endl;
+        else if (program)
+            std::clog << "batches evaluated as bytecode" << std::endl;
+        else
+            std::clog << "batches evaluated point by point" << std::endl;
+    }
+
+    ~Function() {
+        compiled_functions().erase(id);
     }
 
-    double compute(const double x, const double y) {
-        _x = x;
-        _y = y;
-        return expression.value();
+    Function(const Function &) = delete;
+    Function &operator=(const Function &) = delete;
+
+    /**
+     * Evaluates the function. Thread safe: each thread evaluates its own compiled copy of the expression.
+     */
+    double compute(const double x, const double y) const {
+        Compiled &compiled = local();
+        compiled.x = x;
+        compiled.y = y;
+        return compiled.expression.value();
     }
 
-    double operator()(const double x, const double y) {
-        _x = x;
-        _y = y;
-        return expression.value();
+    double operator()(const double x, const double y) const {
+        return compute(x, y);
+    }
+
+    /**
+     * Evaluates the function on n points, as native code or bytecode when the expression allows it. Thread safe.
+     * @param x abscissas of the points
+     * @param y ordinates of the points
+     * @param out the n values
+     */
+    void compute_batch(const double *x, const double *y, double *out, const std::size_t n) const {
+        if (native_function) {
+            native_function->evaluate(x, y, out, n);
+            return;
+        }
+
+        if (program) {
+            program->evaluate(x, y, out, n);
+            return;
+        }
+
+        for (std::size_t i = 0; i < n; ++i)
+            out[i] = compute(x[i], y[i]);
     }
 
 private:
-    double _x = 0.;
-    double _y = 0.;
-    exprtk::expression<double> expression;
-    exprtk::symbol_table<double> symbol_table;
-    exprtk::parser<double> parser;
+    // an expression compiled for one thread, with its own variable storage
+    struct Compiled {
+        double x = 0.;
+        double y = 0.;
+        exprtk::expression<double> expression;
+        exprtk::symbol_table<double> symbol_table;
+
+        explicit Compiled(const std::string &source) {
+            symbol_table.add_variable("x", x);
+            symbol_table.add_variable("y", y);
+            symbol_table.add_function("RND", rnd_double);
+            symbol_table.add_constants();
+
+            expression.register_symbol_table(symbol_table);
+
+            exprtk::parser<double> parser;
+            parser.compile(source, expression);
+        }
+    };
+
+    std::string source;
+    std::size_t id;  // key of the function in the per thread caches, addresses may be reused
+    shared_ptr<FunctionProgram> program;  // bytecode for batches, null if the expression is not supported
+    shared_ptr<NativeFunction> native_function;  // native code for batches, null unless requested and built
+
+    // checks a batch evaluator against exprtk on a grid spanning the pixel and its sampling margin
+    template<typename Evaluator>
+    bool matches_expression(const Evaluator &evaluator) const {
+        constexpr std::size_t side = 9;
+        std::vector<double> x, y;
+        for (std::size_t i = 0; i < side; ++i) {
+            for (std::size_t j = 0; j < side; ++j) {
+                x.push_back(-.6 + 1.2 * (i + .37) / side);
+                y.push_back(-.6 + 1.2 * (j + .61) / side);
+            }
+        }
+
+        std::vector<double> values(x.size());
+        evaluator.evaluate(x.data(), y.data(), values.data(), values.size());
+
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            const double expected = compute(x[i], y[i]);
+            const double value = values[i];
+            if (std::isnan(expected) && std::isnan(value)) continue;
+            if (expected == value) continue;
+            if (std::fabs(expected - value) > 1e-9 * std::max(1., std::fabs(expected))) return false;
+        }
+        return true;
+    }
+
+    static std::size_t next_id() {
+        static std::atomic<std::size_t> counter{0};
+        return counter++;
+    }
+
+    static std::unordered_map<std::size_t, std::unique_ptr<Compiled>> &compiled_functions() {
+        thread_local std::unordered_map<std::size_t, std::unique_ptr<Compiled>> functions;
+        return functions;
+    }
+
+    // the expression compiled for the calling thread, compiled on first use
+    Compiled &local() const {
+        auto &functions = compiled_functions();
+        auto it = functions.find(id);
+        if (it == functions.end())
+            it = functions.emplace(id, std::make_unique<Compiled>(source)).first;
+        return *it->second;
+    }
 };
 
 #endif
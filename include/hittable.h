@@ -27,18 +27,46 @@
 
 #include "yapt.h"
 #include "aabb.h"
+#include "light_bounds.h"
+#include "material_table.h"
 
 class Material;
+class Hittable;
+class RayPacket;
 
+/**
+ * How lights sample the directions toward them: uniformly on their area, or uniformly in the solid angle they
+ * subtend from the shading point
+ */
+enum class LightSampling { Area, SolidAngle };
+
+// solid angle sampling is numerically unstable for tiny solid angles and useless for huge ones
+constexpr double MIN_SOLID_ANGLE_SAMPLING = 3e-4;
+constexpr double MAX_SOLID_ANGLE_SAMPLING = 6.22;
+
+/**
+ * Describes a ray hit. Intersection loops only fill in the distance, the material and what the hit primitive needs
+ * to complete the record; the position, normal and uv of the closest hit are computed once by finalize.
+ */
 class HitRecord {
 public:
     Point3 p;
     Vec3 normal;
-    shared_ptr<Material> mat;
     double t;
     double u;
     double v;
+    const Hittable *deferred = nullptr;  // primitive that still has to complete this record, nullptr when complete
+    uint32_t mat_id = MaterialTable::none;
     bool front_face;
+    int light_id = -1;  // index of the hit object in the light sampler, -1 if it is not a sampled light
+
+    [[nodiscard]] Material *material() const { return MaterialTable::get(mat_id); }
+
+    /**
+     * Completes the record of the closest hit of a ray: position, normal and uv
+     * @param r the ray that produced this record
+     */
+    inline void finalize(const Ray &r);
 
     /**
      * Sets the hit record normal vector
@@ -64,6 +92,19 @@ public:
         return 0.0;
     }
 
+    /**
+     * Evaluates the pdf of sampling the point of a known hit, from an origin. Registered lights use the hit
+     * record instead of intersecting the ray again, and return 0 for hits on other objects. Other hittables
+     * fall back to pdfValue(origin, direction)
+     * @param origin the origin the direction was sampled from
+     * @param direction the sampled direction
+     * @param rec the closest hit along the ray (origin, direction)
+     * @return the pdf of the direction
+     */
+    [[nodiscard]] virtual double pdfValue(const Point3 &origin, const Vec3 &direction, const HitRecord &rec) const {
+        return pdfValue(origin, direction);
+    }
+
     /**
      * Samples a direction to this hittable from an origin
      * @param origin the origin to sample from
@@ -72,8 +113,67 @@ public:
     [[nodiscard]] virtual Vec3 random(const Point3 &origin) const {
         return {1, 0, 0};
     }
+
+    /**
+     * Estimates the power emitted by this hittable (emitted radiance luminance times area). Used to build light
+     * sampling distributions, only the ratios between lights matter.
+     * @return the estimated emitted power, 0 for non emissive hittables
+     */
+    [[nodiscard]] virtual double power() const {
+        return 0.0;
+    }
+
+    /**
+     * Bounds the emission of this hittable, used to build light hierarchies. Hittables emit in all directions
+     * unless they override this method.
+     * @return the position, power and emission directions bounds of this hittable
+     */
+    [[nodiscard]] virtual LightBounds light_bounds() const {
+        return {bounding_box(), power()};
+    }
+
+    /**
+     * Selects how directions toward this hittable are sampled. Hittables with a single sampling method ignore it
+     * @param sampling the sampling method
+     */
+    virtual void set_light_sampling(LightSampling sampling) {}
+
+    /**
+     * Registers this hittable as the light of index id in a light sampler. Hits on this hittable will report it.
+     * @param id index of the light, -1 to unregister
+     */
+    virtual void set_light_id(const int id) {
+        light_id = id;
+    }
+
+    /**
+     * Completes a hit record this hittable left partial in hit
+     * @param r the ray that hit this hittable
+     * @param rec the record to complete
+     */
+    virtual void finalize(const Ray &r, HitRecord &rec) const {}
+
+    /**
+     * Intersects the active rays of a packet, each ray only accepts hits closer than its current closest hit.
+     * The default tests the rays one by one.
+     * @param packet the rays, their records and closest distances are updated on hit
+     * @param ray_t the interval along the rays where hits are accepted
+     * @return the mask of the rays that hit this hittable
+     */
+    virtual uint32_t hit_packet(RayPacket &packet, Interval ray_t) const;
+
+protected:
+    int light_id = -1;
 };
 
+inline void HitRecord::finalize(const Ray &r) {
+    if (deferred) {
+        const Hittable *object = deferred;
+        deferred = nullptr;
+        object->finalize(r, *this);
+    }
+}
+
 class Translate : public Hittable {
 public:
     Translate(const shared_ptr<Hittable>& object, const Vec3 &offset)
@@ -89,14 +189,28 @@ public:
         if (!object->hit(offset_r, ray_t, rec))
             return false;
 
+        // the position has to be known in object space before moving it
+        rec.finalize(offset_r);
+
         // Move the intersection point forwards by the offset
         rec.p += offset;
 
+        if (light_id >= 0)
+            rec.light_id = light_id;
+
         return true;
     }
 
     [[nodiscard]] AABB bounding_box() const override { return bbox; }
 
+    [[nodiscard]] double power() const override { return object->power(); }
+
+    [[nodiscard]] LightBounds light_bounds() const override {
+        LightBounds bounds = object->light_bounds();
+        bounds.bounds = bbox;
+        return bounds;
+    }
+
 private:
     shared_ptr<Hittable> object;
     Vec3 offset;
@@ -154,6 +268,9 @@ public:
         if (!object->hit(rotated_r, ray_t, rec))
             return false;
 
+        // the position and normal have to be known in object space before rotating them
+        rec.finalize(rotated_r);
+
         // Change the intersection point from object space to world space
         auto p = rec.p;
         p[0] = cos_theta * rec.p[0] + sin_theta * rec.p[2];
@@ -167,11 +284,25 @@ public:
         rec.p = p;
         rec.normal = normal;
 
+        if (light_id >= 0)
+            rec.light_id = light_id;
+
         return true;
     }
 
     [[nodiscard]] AABB bounding_box() const override { return bbox; }
 
+    [[nodiscard]] double power() const override { return object->power(); }
+
+    [[nodiscard]] LightBounds light_bounds() const override {
+        LightBounds bounds = object->light_bounds();
+        const Vec3 w = bounds.w;
+        bounds.w[0] = cos_theta * w[0] + sin_theta * w[2];
+        bounds.w[2] = -sin_theta * w[0] + cos_theta * w[2];
+        bounds.bounds = bbox;
+        return bounds;
+    }
+
 private:
     shared_ptr<Hittable> object;
     double sin_theta;
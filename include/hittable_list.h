@@ -43,12 +43,16 @@ public:
 
     bool hit(const Ray &r, Interval ray_t, HitRecord &record) const override;
 
+    uint32_t hit_packet(RayPacket &packet, Interval ray_t) const override;
+
     [[nodiscard]] AABB bounding_box() const override;
 
     [[nodiscard]] double pdfValue(const Point3 &origin, const Vec3 &direction) const override;
 
     [[nodiscard]] Vec3 random(const Point3 &origin) const override;
 
+    [[nodiscard]] double power() const override;
+
 private:
     AABB bbox;
 };
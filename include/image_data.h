@@ -26,12 +26,67 @@
 #define YAPT_IMAGE_DATA_H
 
 #include <cstdint>
+#include <string>
 #include <vector>
 
+/**
+ * Float32 framebuffer: the rgb beauty image and optional named layers (AOVs), all stored row major
+ */
 struct ImageData {
-    size_t width;
-    size_t height;
-    std::vector<double> data;
+    struct Layer {
+        std::string name;
+        size_t channels;
+        std::vector<float> data;
+    };
+
+    size_t width = 0;
+    size_t height = 0;
+    std::vector<float> data;    // beauty, rgb
+    std::vector<Layer> layers;
+
+    /**
+     * Adds a zeroed layer covering the image, references to the other layers are invalidated
+     */
+    Layer &add_layer(const std::string &name, const size_t channels) {
+        layers.push_back({name, channels, std::vector<float>(width * height * channels)});
+        return layers.back();
+    }
+
+    [[nodiscard]] const Layer *layer(const std::string &name) const {
+        for (const auto &l : layers)
+            if (l.name == name) return &l;
+        return nullptr;
+    }
+};
+
+/**
+ * Receives the finished lines of an image while it renders, so that the whole image is never held in memory.
+ * The render threads call write concurrently, with disjoint bands aligned on band_height.
+ */
+class TileSink {
+public:
+    virtual ~TileSink() = default;
+
+    /**
+     * Prepares the output, before the first band is written
+     */
+    virtual void open(size_t width, size_t height) = 0;
+
+    /**
+     * Number of lines of the bands handed to write
+     */
+    [[nodiscard]] virtual size_t band_height() const = 0;
+
+    /**
+     * Stores lines [first_row, first_row + rows) of the image
+     * @param data rgb values of the lines, row major
+     */
+    virtual void write(size_t first_row, size_t rows, const float *data) = 0;
+
+    /**
+     * Completes the output, once every band is written
+     */
+    virtual void close() = 0;
 };
 
 #endif //YAPT_IMAGE_DATA_H
@@ -29,6 +29,9 @@
 #include <string>
 #include "image_data.h"
 #include <memory>
+#include <mutex>
+#include <fstream>
+#include <filesystem>
 
 #include "camera.h"
 
@@ -61,14 +64,70 @@ protected:
     shared_ptr<ImageData> image_data;
 };
 
+/**
+ * Writes OpenEXR images, tiled by default, compressing the tiles on the OpenEXR thread pool
+ */
 class EXRImageExporter final : public ImageExporter {
 public:
     explicit EXRImageExporter(const shared_ptr<ImageData> image_data): image_data(image_data) {}
     void write(std::string fileName) override;
 
+    bool halfChannels = true;           // half or float channels
+    std::string compression = "zip";    // none, rle, zips, zip, piz, pxr24, b44, b44a, dwaa or dwab
+    int tileSize = 64;                  // side of the tiles, 0 writes scanlines
+    int numThreads = 0;                 // compression threads, 0 uses hardware_concurrency
+
 protected:
     shared_ptr<ImageData> image_data;
-    size_t render_time = 0;
+};
+
+/**
+ * Streams an image into a tiled OpenEXR file as its bands are rendered, tiles being written in completion order
+ */
+class EXRTileSink final : public TileSink {
+public:
+    EXRTileSink(std::string fileName, bool halfChannels, std::string compression, int tileSize, int numThreads);
+    ~EXRTileSink() override;
+
+    void open(size_t width, size_t height) override;
+    [[nodiscard]] size_t band_height() const override;
+    void write(size_t first_row, size_t rows, const float *data) override;
+    void close() override;
+
+protected:
+    struct File;
+
+    std::string fileName;
+    bool halfChannels;
+    std::string compression;
+    int tileSize;
+    int numThreads;
+    size_t width = 0;
+    std::unique_ptr<File> file;
+    std::mutex mutex;
+};
+
+/**
+ * Streams an image into a raw file: a 24 bytes header ("YAPTRAW" and a null byte, then width and height as
+ * little endian uint64) followed by the row major float32 rgb pixels, so that the file maps directly to an array
+ */
+class RawTileSink final : public TileSink {
+public:
+    explicit RawTileSink(std::filesystem::path path, size_t bandHeight = 16);
+
+    void open(size_t width, size_t height) override;
+    [[nodiscard]] size_t band_height() const override { return bandHeight; }
+    void write(size_t first_row, size_t rows, const float *data) override;
+    void close() override;
+
+    static constexpr size_t headerSize = 24;
+
+protected:
+    std::filesystem::path path;
+    size_t bandHeight;
+    size_t width = 0;
+    std::ofstream out;
+    std::mutex mutex;
 };
 
 #endif //YAPT_IMAGE_EXPORTER_H
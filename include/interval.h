@@ -25,31 +25,52 @@
 #ifndef YAPT_INTERVAL_H
 #define YAPT_INTERVAL_H
 
+#include "constants.h"
+
 class Interval {
 public:
     double min, max;
 
-    Interval();
+    constexpr Interval() : min(+infinity), max(-infinity) {}
 
-    Interval(double min, double max);
+    constexpr Interval(const double min, const double max) : min(min), max(max) {}
 
-    Interval(const Interval &a, const Interval &b);
+    constexpr Interval(const Interval &a, const Interval &b)
+        // Create the interval tightly enclosing the two input intervals.
+        : min(a.min <= b.min ? a.min : b.min), max(a.max >= b.max ? a.max : b.max) {}
 
-    [[nodiscard]] double size() const;
+    [[nodiscard]] constexpr double size() const {
+        return max - min;
+    }
 
-    [[nodiscard]] bool contains(double x) const;
+    [[nodiscard]] constexpr bool contains(const double x) const {
+        return min <= x && x <= max;
+    }
 
-    [[nodiscard]] bool surrounds(double x) const;
+    [[nodiscard]] constexpr bool surrounds(const double x) const {
+        return min < x && x < max;
+    }
 
-    [[nodiscard]] double clamp(double x) const;
+    [[nodiscard]] constexpr double clamp(const double x) const {
+        if (x < min) return min;
+        if (x > max) return max;
+        return x;
+    }
 
-    [[nodiscard]] Interval expand(double delta) const;
+    [[nodiscard]] constexpr Interval expand(const double delta) const {
+        const auto padding = delta / 2;
+        return {min - padding, max + padding};
+    }
 
     static const Interval empty, universe, future;
 };
 
-Interval operator+(const Interval &interval, double displacement);
+constexpr Interval operator+(const Interval &interval, const double displacement) {
+    return {interval.min + displacement, interval.max + displacement};
+}
 
-Interval operator+(double displacement, const Interval &interval);
+constexpr Interval operator+(const double displacement, const Interval &interval) {
+    return interval + displacement;
+}
 
 #endif //YAPT_INTERVAL_H
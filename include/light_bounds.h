@@ -0,0 +1,70 @@
+/*
+ * This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
+ * Copyright (c) 2025 PrISE-3D.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * --- ADDITIONAL PERMISSION UNDER GNU GPL VERSION 3 SECTION 7 ---
+ *
+ * If you modify this Program, or any covered work, by linking or
+ * combining it with the Intel Math Kernel Library (MKL) (or a modified
+ * version of that library), containing parts covered by the terms of
+ * the Intel Simplified Software License, the licensors of this
+ * Program grant you additional permission to convey the resulting work.
+ */
+
+#ifndef YAPT_LIGHT_BOUNDS_H
+#define YAPT_LIGHT_BOUNDS_H
+
+#include "yapt.h"
+#include "aabb.h"
+
+/**
+ * Conservative bounds on the emission of one light or a cluster of lights: where it lies, how much power it emits
+ * and in which directions (normal cone of axis w and half angle theta_o, widened by the emission spread theta_e).
+ * Used to estimate the contribution of a cluster of lights to a shading point.
+ */
+class LightBounds {
+public:
+    AABB bounds;
+    Vec3 w;                    // axis of the normal cone
+    double phi = 0;            // emitted power
+    double cos_theta_o = -1;   // cosine of the normal cone half angle, -1 for all directions
+    double cos_theta_e = 0;    // cosine of the emission spread around each normal, 0 for a lambertian emitter
+    bool two_sided = false;
+
+    LightBounds() = default;
+
+    /**
+     * Bounds of a light emitting in all directions
+     */
+    LightBounds(const AABB &bounds, double phi);
+
+    LightBounds(const AABB &bounds, const Vec3 &w, double phi, double cos_theta_o, double cos_theta_e, bool two_sided);
+
+    /**
+     * Estimates the contribution of the bounded lights to a point. This is an upper bound shape, not a
+     * physical value: only the ratios between clusters matter.
+     * @param p the shading point
+     * @return the importance of the bounded lights for p, 0 if they cannot illuminate it
+     */
+    [[nodiscard]] double importance(const Point3 &p) const;
+
+    /**
+     * @return the bounds of both clusters
+     */
+    static LightBounds merge(const LightBounds &a, const LightBounds &b);
+
+    [[nodiscard]] Point3 centroid() const;
+};
+
+#endif //YAPT_LIGHT_BOUNDS_H
@@ -0,0 +1,67 @@
+/*
+ * This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
+ * Copyright (c) 2025 PrISE-3D.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * --- ADDITIONAL PERMISSION UNDER GNU GPL VERSION 3 SECTION 7 ---
+ *
+ * If you modify this Program, or any covered work, by linking or
+ * combining it with the Intel Math Kernel Library (MKL) (or a modified
+ * version of that library), containing parts covered by the terms of
+ * the Intel Simplified Software License, the licensors of this
+ * Program grant you additional permission to convey the resulting work.
+ */
+
+#ifndef YAPT_LIGHT_BVH_H
+#define YAPT_LIGHT_BVH_H
+
+#include "yapt.h"
+#include "light_sampler.h"
+#include "light_bounds.h"
+#include <vector>
+
+/**
+ * Chooses lights by traversing a hierarchy of light bounds. At each node the child is chosen with a probability
+ * proportional to its importance for the shading point, which accounts for the power, the distance and the
+ * orientation of the lights it contains. Choosing a light costs O(log(lights)), as does evaluating its probability,
+ * which is obtained by replaying the path to the light stored as a bit trail.
+ */
+class LightBVH : public LightSampler {
+public:
+    explicit LightBVH(const shared_ptr<HittableList> &lights);
+
+    [[nodiscard]] std::size_t pick(const Point3 &origin) const override;
+    [[nodiscard]] double probability(std::size_t index, const Point3 &origin) const override;
+
+private:
+    struct Node {
+        LightBounds bounds;
+        std::size_t index = 0;  // second child for interior nodes (the first one follows its parent), light for leaves
+        bool leaf = false;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<uint64_t> trails;  // for each light, the path from the root: bit d set if the right child is taken at depth d
+
+    std::size_t build(std::vector<std::pair<std::size_t, LightBounds>> &items, std::size_t start, std::size_t end,
+                      uint64_t trail, int depth);
+
+    /**
+     * @param node the index of an interior node
+     * @param origin the shading point
+     * @return the probability to go down the first child of the node
+     */
+    [[nodiscard]] double left_probability(std::size_t node, const Point3 &origin) const;
+};
+
+#endif //YAPT_LIGHT_BVH_H
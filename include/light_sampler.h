@@ -0,0 +1,151 @@
+/*
+ * This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
+ * Copyright (c) 2025 PrISE-3D.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * --- ADDITIONAL PERMISSION UNDER GNU GPL VERSION 3 SECTION 7 ---
+ *
+ * If you modify this Program, or any covered work, by linking or
+ * combining it with the Intel Math Kernel Library (MKL) (or a modified
+ * version of that library), containing parts covered by the terms of
+ * the Intel Simplified Software License, the licensors of this
+ * Program grant you additional permission to convey the resulting work.
+ */
+
+#ifndef YAPT_LIGHT_SAMPLER_H
+#define YAPT_LIGHT_SAMPLER_H
+
+#include "yapt.h"
+#include "hittable.h"
+#include "hittable_list.h"
+#include <vector>
+
+/**
+ * Walker's alias table: samples an index of a discrete distribution in O(1)
+ */
+class AliasTable {
+public:
+    AliasTable() = default;
+
+    /**
+     * Builds the table from non negative weights. Weights are normalized, they do not need to sum to 1.
+     * @param weights the (unnormalized) weights of the distribution. If they all are null, the uniform
+     * distribution is used instead
+     */
+    explicit AliasTable(const std::vector<double> &weights);
+
+    /**
+     * Samples an index according to the distribution
+     * @param u a uniform random number in [0, 1)
+     * @return the sampled index
+     */
+    [[nodiscard]] std::size_t sample(double u) const;
+
+    /**
+     * @param index an index of the distribution
+     * @return the probability to sample this index
+     */
+    [[nodiscard]] double probability(std::size_t index) const { return probabilities[index]; }
+
+    [[nodiscard]] std::size_t size() const { return probabilities.size(); }
+
+private:
+    std::vector<double> probabilities;  // normalized distribution
+    std::vector<double> thresholds;     // probability to keep a bin instead of jumping to its alias
+    std::vector<std::size_t> aliases;
+};
+
+/**
+ * Chooses a light among the scene lights before delegating direction sampling to it.
+ * The sampler registers the index of each light in the light itself so that hit records report the light they hit,
+ * which allows evaluating the pdf of a direction without testing every light when the hit is already known.
+ */
+class LightSampler : public Hittable {
+public:
+    explicit LightSampler(const shared_ptr<HittableList> &lights);
+
+    bool hit(const Ray &r, Interval ray_t, HitRecord &rec) const override;
+
+    [[nodiscard]] AABB bounding_box() const override { return bbox; }
+
+    /**
+     * Evaluates the pdf of a direction by summing the contributions of all lights. O(lights)
+     */
+    [[nodiscard]] double pdfValue(const Point3 &origin, const Vec3 &direction) const override;
+
+    /**
+     * Evaluates the pdf of sampling the light point of a known hit: the probability to choose the hit light times
+     * its own pdf, without intersecting the ray again. Hits on objects that are not lights have a null pdf.
+     */
+    [[nodiscard]] double pdfValue(const Point3 &origin, const Vec3 &direction, const HitRecord &rec) const override;
+
+    [[nodiscard]] Vec3 random(const Point3 &origin) const override;
+
+    [[nodiscard]] double power() const override;
+
+    /**
+     * Chooses a light to sample from a shading point
+     * @param origin the shading point
+     * @return the index of the chosen light
+     */
+    [[nodiscard]] virtual std::size_t pick(const Point3 &origin) const = 0;
+
+    /**
+     * @param index the index of a light
+     * @param origin the shading point
+     * @return the probability to choose this light from the shading point
+     */
+    [[nodiscard]] virtual double probability(std::size_t index, const Point3 &origin) const = 0;
+
+    [[nodiscard]] std::size_t size() const { return lights.size(); }
+
+    [[nodiscard]] const shared_ptr<Hittable> &light(const std::size_t index) const { return lights[index]; }
+
+protected:
+    /**
+     * Computes the sampling weight of each light from its estimated power. Lights with no estimated power
+     * (eg. non emissive objects used as sampling portals) are given the average weight of the emissive ones.
+     * @return one weight per light
+     */
+    [[nodiscard]] std::vector<double> power_weights() const;
+
+    std::vector<shared_ptr<Hittable>> lights;
+    AABB bbox;
+};
+
+/**
+ * Chooses lights uniformly
+ */
+class UniformLightSampler : public LightSampler {
+public:
+    explicit UniformLightSampler(const shared_ptr<HittableList> &lights);
+
+    [[nodiscard]] std::size_t pick(const Point3 &origin) const override;
+    [[nodiscard]] double probability(std::size_t index, const Point3 &origin) const override;
+};
+
+/**
+ * Chooses lights proportionally to their emitted power, using an alias table built at scene load
+ */
+class PowerLightSampler : public LightSampler {
+public:
+    explicit PowerLightSampler(const shared_ptr<HittableList> &lights);
+
+    [[nodiscard]] std::size_t pick(const Point3 &origin) const override;
+    [[nodiscard]] double probability(std::size_t index, const Point3 &origin) const override;
+
+private:
+    AliasTable table;
+};
+
+#endif //YAPT_LIGHT_SAMPLER_H
@@ -57,6 +57,21 @@ public:
     const {
         return 0;
     }
+
+    /**
+     * Representative radiance emitted by this material, used to estimate the power of light sources
+     * @return the emitted radiance, black for non emissive materials
+     */
+    [[nodiscard]] virtual Color emission() const {
+        return {0, 0, 0};
+    }
+
+    /**
+     * Reflectance of the material at a hit, as seen by denoisers and the albedo layer
+     */
+    [[nodiscard]] virtual Color albedo_at(const HitRecord &rec) const {
+        return {1, 1, 1};
+    }
 };
 
 class Lambertian : public Material {
@@ -69,6 +84,8 @@ public:
 
     double scattering_pdf(const Ray &r_in, const HitRecord &rec, const Ray &scattered) const override;
 
+    [[nodiscard]] Color albedo_at(const HitRecord &rec) const override;
+
 private:
     shared_ptr<Texture> tex;
 };
@@ -79,6 +96,8 @@ public:
 
     bool scatter(const Ray &r_in, const HitRecord &rec, ScatterRecord &scatterRecord) const override;
 
+    [[nodiscard]] Color albedo_at(const HitRecord &rec) const override { return albedo; }
+
 private:
     Color albedo;
     double fuzz;
@@ -110,6 +129,10 @@ public:
         return tex->value(u, v, p);
     }
 
+    [[nodiscard]] Color emission() const override {
+        return tex->value(.5, .5, Point3(0, 0, 0));
+    }
+
 private:
     shared_ptr<Texture> tex;
 };
@@ -124,6 +147,8 @@ public:
 
     double scattering_pdf(const Ray &r_in, const HitRecord &rec, const Ray &scattered) const override;
 
+    [[nodiscard]] Color albedo_at(const HitRecord &rec) const override;
+
 private:
     shared_ptr<Texture> tex;
 };
@@ -0,0 +1,64 @@
+/*
+ * This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
+ * Copyright (c) 2025 PrISE-3D.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * --- ADDITIONAL PERMISSION UNDER GNU GPL VERSION 3 SECTION 7 ---
+ *
+ * If you modify this Program, or any covered work, by linking or
+ * combining it with the Intel Math Kernel Library (MKL) (or a modified
+ * version of that library), containing parts covered by the terms of
+ * the Intel Simplified Software License, the licensors of this
+ * Program grant you additional permission to convey the resulting work.
+ */
+
+#ifndef YAPT_MATERIAL_TABLE_H
+#define YAPT_MATERIAL_TABLE_H
+
+#include "yapt.h"
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+class Material;
+
+/**
+ * Registry of the materials of the scene. Hit records refer to materials by their index in this table instead of
+ * holding shared pointers, so that intersecting does not touch reference counts.
+ * Materials are registered when primitives are built, which must happen before rendering: the table is not
+ * synchronized for concurrent registrations and lookups.
+ */
+class MaterialTable {
+public:
+    static constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+
+    /**
+     * Registers a material, once
+     * @param material the material to register
+     * @return the index of the material, none for a null material
+     */
+    static uint32_t add(const shared_ptr<Material> &material);
+
+    /**
+     * @param id the index of a registered material
+     * @return the material, nullptr for none
+     */
+    static Material *get(const uint32_t id) {
+        return id == none ? nullptr : materials[id].get();
+    }
+
+private:
+    static std::vector<shared_ptr<Material>> materials;
+};
+
+#endif //YAPT_MATERIAL_TABLE_H
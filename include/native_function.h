@@ -0,0 +1,72 @@
+/*
+ * This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
+ * Copyright (c) 2025 PrISE-3D.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * --- ADDITIONAL PERMISSION UNDER GNU GPL VERSION 3 SECTION 7 ---
+ *
+ * If you modify this Program, or any covered work, by linking or
+ * combining it with the Intel Math Kernel Library (MKL) (or a modified
+ * version of that library), containing parts covered by the terms of
+ * the Intel Simplified Software License, the licensors of this
+ * Program grant you additional permission to convey the resulting work.
+ */
+
+#ifndef YAPT_NATIVE_FUNCTION_H
+#define YAPT_NATIVE_FUNCTION_H
+
+#include "yapt.h"
+#include "function_program.h"
+#include <filesystem>
+#include <string>
+
+/**
+ * A function program compiled to native code: the program is translated to C++, built as a shared object by the
+ * system compiler ($CXX, c++ by default) and loaded with dlopen. Shared objects are cached by hash of their
+ * compiler command, compiler version and source in $YAPT_JIT_CACHE, else $XDG_CACHE_HOME/yapt-jit or
+ * ~/.cache/yapt-jit. The cache directory is created private (0700) and neither it nor a cached object is loaded
+ * unless owned by the effective user and not writable by group or others.
+ */
+class NativeFunction {
+public:
+    using Batch = void (*)(const double *x, const double *y, double *out, std::size_t n);
+
+    /**
+     * Compiles a program, or loads it from the cache
+     * @param program the program to compile
+     * @return the native function, nullptr if it could not be built or loaded
+     */
+    static shared_ptr<NativeFunction> compile(const FunctionProgram &program);
+
+    ~NativeFunction();
+
+    NativeFunction(const NativeFunction &) = delete;
+    NativeFunction &operator=(const NativeFunction &) = delete;
+
+    /**
+     * Evaluates the function on n points. Thread safe.
+     */
+    void evaluate(const double *x, const double *y, double *out, const std::size_t n) const {
+        batch(x, y, out, n);
+    }
+
+private:
+    NativeFunction(void *handle, Batch batch) : handle(handle), batch(batch) {}
+
+    static std::filesystem::path cache_directory();
+
+    void *handle;
+    Batch batch;
+};
+
+#endif //YAPT_NATIVE_FUNCTION_H
@@ -29,10 +29,15 @@
 
 #include <filesystem>
 #include <regex>
+#include <sstream>
 
+#include "denoiser.h"
 #include "image_exporter.h"
 #include "sceneloader.h"
+#include "torch_aggregator.h"
 #include "scene.h"
+#include "wavefront.h"
+#include "ray_packet.h"
 #include "exprtk/exprtk.hpp"
 
 class Parser {
@@ -41,16 +46,19 @@ protected:
     std::shared_ptr<Camera> camera = std::make_shared<ForwardParallelCamera>();
     std::shared_ptr<HittableList> content = make_shared<HittableList>();
     std::shared_ptr<HittableList> lights = make_shared<HittableList>();
+    std::shared_ptr<LightSampler> lightSampler;
     std::shared_ptr<SamplerFactory> samplerFactory;
     std::shared_ptr<AggregatorFactory> aggregatorFactory;
     std::filesystem::path source = "../scenes/cornell.ypt";
     std::string cameraType = "std";
     std::string aggregator = "vor";
     std::string sampler = "sppp";
+    std::string lightSamplerType = "power";
     std::size_t spp = 100;
     double confidence = .999;
     std::size_t maxDepth = 25;
     std::size_t numThreads = 0;
+    std::size_t packetSize = 1;
     std::size_t width = 0;
     std::size_t pixel_x = 0;
     std::size_t pixel_y = 0;
@@ -58,6 +66,21 @@ protected:
     bool winClip = false;
     double winRate = .05;
     bool nee = false;
+    bool jit = false;
+    bool halfChannels = true;
+    std::string compression = "zip";
+    int tileSize = 64;
+    bool stream = false;
+    std::vector<std::string> aovs;
+    std::filesystem::path dumpPath;
+    std::vector<std::size_t> dumpRegion;
+    bool dumpCompress = true;
+    std::filesystem::path denoisePath;
+    std::size_t denoiseThreads = 0;
+    std::size_t denoiseTile = 256;
+    std::shared_ptr<Denoiser> denoiser;
+    std::filesystem::path torchModel;
+    std::size_t guidingPasses = 0;
 
     long seed;
     bool silent = false;
@@ -73,6 +96,7 @@ protected:
     shared_ptr<Camera> getCamera() { return camera; }
     shared_ptr<HittableList> getContent() { return content; }
     shared_ptr<HittableList> getLights() { return lights; }
+    shared_ptr<LightSampler> getLightSampler() { return lightSampler; }
     shared_ptr<SamplerFactory> getSamplerFactory() { return samplerFactory; }
     shared_ptr<AggregatorFactory> getAggregatorFactory() { return aggregatorFactory; }
 
@@ -80,6 +104,17 @@ protected:
     std::size_t getWidth() const { return width; }
     std::size_t getSPP() const { return spp; }
 
+    /**
+     * Changes the samples per pixel of a loaded scene, rebuilding its sampler and aggregator factories
+     */
+    void setSPP(const std::size_t spp, const Scene& scene) {
+        this->spp = spp;
+        samplerFactory = createSamplerFactory(sampler, this->spp, confidence);
+        aggregatorFactory = createAggregatorFactory(aggregator, samplerFactory, monSize, winRate, winClip, torchModel);
+        scene.camera->pixelSamplerFactory = samplerFactory;
+        scene.camera->samplerAggregator = aggregatorFactory;
+    }
+
     void startTimer() {
         start = std::chrono::system_clock::now();
     }
@@ -89,6 +124,85 @@ protected:
         render_time = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
     }
 
+    /**
+     * Creates a pixel sampler factory by name (rnd, strat or sppp)
+     * @param sampler name of the sampling method
+     * @param spp samples per pixel, rounded down to a square for stratified sampling
+     * @param confidence Voronoi aggregation confidence
+     * @return the factory, nullptr for an unknown name
+     */
+    static shared_ptr<SamplerFactory> createSamplerFactory(const std::string &sampler, std::size_t &spp,
+                                                           const double confidence) {
+        shared_ptr<SamplerFactory> samplerFactory;
+
+        if (sampler == "rnd") {
+            samplerFactory = std::make_shared<TrivialSamplerFactory>(spp);
+        } else if (sampler == "strat") {
+            auto sqrtSpp = static_cast<std::size_t>(sqrt(spp));
+            samplerFactory = std::make_shared<StratifiedSamplerFactory>(sqrtSpp);
+            if ((sqrtSpp * sqrtSpp) < spp) {
+                std::cerr << "WARNING: spp is not a square. using spp=" << sqrtSpp * sqrtSpp << std::endl;
+            }
+            spp = sqrtSpp * sqrtSpp;
+        } else if (sampler == "sppp") {
+            samplerFactory = std::make_shared<SkewedPPPSamplerFactory>(spp, confidence);
+        }
+
+        return samplerFactory;
+    }
+
+    /**
+     * Creates an aggregator factory by name (mc, vor, cvor, fvor, nvor, median, mon, winsor or torch)
+     * @param aggregator name of the aggregation method
+     * @param samplerFactory the pixel sampler factory, its margin is used by fvor and nvor
+     * @param monSize number of MoN blocks
+     * @param winRate Winsor reject rate
+     * @param winClip Winsor clipping
+     * @param model TorchScript model of the torch aggregation
+     * @return the factory, nullptr for an unknown name or a model that cannot be loaded
+     */
+    static shared_ptr<AggregatorFactory> createAggregatorFactory(const std::string &aggregator,
+                                                                 const shared_ptr<SamplerFactory> &samplerFactory,
+                                                                 const std::size_t monSize, const double winRate,
+                                                                 const bool winClip,
+                                                                 const std::filesystem::path &model = {}) {
+        shared_ptr<AggregatorFactory> aggregatorFactory;
+
+        if (aggregator == "mc") {
+            aggregatorFactory = std::make_shared<MCAggregatorFactory>();
+        } else if (aggregator == "vor") {
+            aggregatorFactory = std::make_shared<VoronoiAggregatorFactory>();
+        } else if (aggregator == "cvor") {
+            aggregatorFactory = std::make_shared<ClippedVoronoiAggregatorFactory>();
+        } else if (aggregator == "fvor" || aggregator == "nvor") {
+
+            auto sampler = samplerFactory->create(0, 0);
+            auto sppp_sampler = dynamic_cast<SkewedPPPSampler*>(sampler.get());
+
+            double margin = .1;
+            if (sppp_sampler != nullptr) {
+                margin = sppp_sampler->margin;
+            }
+
+            if (aggregator == "fvor") aggregatorFactory = std::make_shared<FilteringVoronoiAggregatorFactory>(margin);
+            if (aggregator == "nvor") aggregatorFactory = std::make_shared<NicoVoronoiAggregatorFactory>(margin);
+        } else if (aggregator == "median") {
+            aggregatorFactory = std::make_shared<MedianAggregatorFactory>();
+        } else if (aggregator == "mon") {
+            aggregatorFactory = std::make_shared<MonAggregatorFactory>(monSize);
+        } else if (aggregator == "winsor") {
+            aggregatorFactory = std::make_shared<WinsorAggregatorFactory>(winRate, winClip);
+        } else if (aggregator == "torch") {
+            try {
+                aggregatorFactory = std::make_shared<TorchAggregatorFactory>(model);
+            } catch (const std::exception &e) {
+                std::cerr << "Cannot load the aggregation model " << model << ": " << e.what() << std::endl;
+            }
+        }
+
+        return aggregatorFactory;
+    }
+
     bool parseScene(int argc, char* argv[], Scene& scene) {
         seed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
 
@@ -107,6 +221,22 @@ protected:
         const std::string silentprefix = "silent";
         const std::string seedprefix = "seed=";
         const std::string neeprefix = "nee=";
+        const std::string lightsamplerprefix = "lightsampler=";
+        const std::string packetprefix = "packet=";
+        const std::string jitprefix = "jit=";
+        const std::string exrtypeprefix = "exrtype=";
+        const std::string compressionprefix = "compression=";
+        const std::string tileprefix = "tile=";
+        const std::string streamprefix = "stream=";
+        const std::string aovsprefix = "aovs=";
+        const std::string dumpprefix = "dump=";
+        const std::string dumpregionprefix = "dumpregion=";
+        const std::string dumpcompressprefix = "dumpcompress=";
+        const std::string denoiseprefix = "denoise=";
+        const std::string torchmodelprefix = "torchmodel=";
+        const std::string guidingprefix = "guiding=";
+        const std::string denoisethreadsprefix = "denoisethreads=";
+        const std::string denoisetileprefix = "denoisetile=";
 
         const std::regex pixelcam_coords(R"(cam=pixel-([0-9]+),([0-9]+))");
         const std::regex singlecam_coords(R"(cam=one-([0-9]+),([0-9]+))");
@@ -157,6 +287,64 @@ protected:
                 std::string b = parameter.substr(neeprefix.size());
                 nee = (b == "true");
             }
+            else if (parameter.rfind(lightsamplerprefix, 0) == 0) {
+                lightSamplerType = parameter.substr(lightsamplerprefix.size());
+            }
+            else if (parameter.rfind(jitprefix, 0) == 0) {
+                std::string b = parameter.substr(jitprefix.size());
+                jit = (b == "true");
+            }
+            else if (parameter.rfind(exrtypeprefix, 0) == 0) {
+                halfChannels = parameter.substr(exrtypeprefix.size()) != "float";
+            }
+            else if (parameter.rfind(compressionprefix, 0) == 0) {
+                compression = parameter.substr(compressionprefix.size());
+            }
+            else if (parameter.rfind(tileprefix, 0) == 0) {
+                tileSize = std::stoi(parameter.substr(tileprefix.size()));
+            }
+            else if (parameter.rfind(aovsprefix, 0) == 0) {
+                std::stringstream list(parameter.substr(aovsprefix.size()));
+                std::string aov;
+                while (std::getline(list, aov, ','))
+                    if (!aov.empty()) aovs.push_back(aov);
+            }
+            else if (parameter.rfind(dumpregionprefix, 0) == 0) {
+                std::stringstream list(parameter.substr(dumpregionprefix.size()));
+                std::string bound;
+                dumpRegion.clear();
+                while (std::getline(list, bound, ','))
+                    dumpRegion.push_back(std::stoul(bound));
+            }
+            else if (parameter.rfind(dumpcompressprefix, 0) == 0) {
+                std::string b = parameter.substr(dumpcompressprefix.size());
+                dumpCompress = b == "true";
+            }
+            else if (parameter.rfind(dumpprefix, 0) == 0) {
+                dumpPath = parameter.substr(dumpprefix.size());
+            }
+            else if (parameter.rfind(denoisethreadsprefix, 0) == 0) {
+                denoiseThreads = std::stoul(parameter.substr(denoisethreadsprefix.size()));
+            }
+            else if (parameter.rfind(denoisetileprefix, 0) == 0) {
+                denoiseTile = std::stoul(parameter.substr(denoisetileprefix.size()));
+            }
+            else if (parameter.rfind(denoiseprefix, 0) == 0) {
+                denoisePath = parameter.substr(denoiseprefix.size());
+            }
+            else if (parameter.rfind(torchmodelprefix, 0) == 0) {
+                torchModel = parameter.substr(torchmodelprefix.size());
+            }
+            else if (parameter.rfind(guidingprefix, 0) == 0) {
+                guidingPasses = std::stoul(parameter.substr(guidingprefix.size()));
+            }
+            else if (parameter.rfind(streamprefix, 0) == 0) {
+                std::string b = parameter.substr(streamprefix.size());
+                stream = b == "true";
+            }
+            else if (parameter.rfind(packetprefix, 0) == 0) {
+                packetSize = std::stoi(parameter.substr(packetprefix.size()));
+            }
             else if (parameter.rfind(silentprefix, 0) == 0) {
                 silent = true;
             }
@@ -180,6 +368,7 @@ protected:
                 std::cout << "                 - median => Median aggregation" << std::endl;
                 std::cout << "                 - mon    => MoN (Median Of meaNs) aggregation" << std::endl;
                 std::cout << "                 - winsor =>  Winsorization" << std::endl;
+                std::cout << "                 - torch  => sample weights inferred by a TorchScript model (torchmodel)" << std::endl;
                 std::cout << " - confidence => Voronoi aggregation confidence (DEFAULT=.999)" << std::endl;
                 std::cout << " - source     => Scene model to import" << std::endl;
                 std::cout << " - maxdepth   => maximum path depth (DEFAULT=25)" << std::endl;
@@ -190,6 +379,7 @@ protected:
                 std::cout << "                 - std       => standard camera type (DEFAULT) " << std::endl;
                 std::cout << "                 - norm      => renders normals to surfaces " << std::endl;
                 std::cout << "                 - biased    => biased, low non-contribution camera" << std::endl;
+                std::cout << "                 - wavefront => standard rendering, paths traced as streams" << std::endl;
                 std::cout << "                 - test      => test camera" << std::endl;
                 std::cout << "                 - pixel-x,y => pixel cartography camera @coords (x,y)" << std::endl;
                 std::cout << "                 - one-x,y   => renders only one pixel @coords (x,y)" << std::endl;
@@ -198,6 +388,27 @@ protected:
                 std::cout << " - winclip    => Winsor clipping (DEFAULT = false)" << std::endl;
                 std::cout << " - seed       => RNG seed (DEFAULT = random seed)" << std::endl;
                 std::cout << " - nee        => Next Event Estimation (DEFAULT = false)" << std::endl;
+                std::cout << " - guiding    => path guiding, learned in N passes of 1, 2, 4... spp before rendering (DEFAULT = 0, off)" << std::endl;
+                std::cout << " - lightsampler => light selection method:" << std::endl;
+                std::cout << "                 - uniform => uniform choice among lights" << std::endl;
+                std::cout << "                 - power   => choice proportional to emitted power (DEFAULT)" << std::endl;
+                std::cout << "                 - bvh     => light hierarchy, choice by power, distance and orientation" << std::endl;
+                std::cout << " - packet     => primary rays traced together per pixel, up to 16 (DEFAULT = 1, no packets)" << std::endl;
+                std::cout << " - jit        => compiles .func sources to native code with $CXX (DEFAULT = false)" << std::endl;
+                std::cout << " - exrtype    => EXR channels, half or float (DEFAULT = half)" << std::endl;
+                std::cout << " - compression => EXR codec: none, rle, zips, zip, piz, pxr24, b44, b44a, dwaa, dwab (DEFAULT = zip)" << std::endl;
+                std::cout << " - tile       => EXR tile side, 0 writes scanlines (DEFAULT = 64)" << std::endl;
+                std::cout << " - aovs       => comma separated extra EXR layers: albedo, normal, depth, variance, count, mc" << std::endl;
+                std::cout << " - dump       => file receiving the samples, contributions and weights of the pixels (optional)" << std::endl;
+                std::cout << " - dumpregion => x0,y0,x1,y1: dumps only the pixels in [x0, x1) x [y0, y1) (DEFAULT = whole image)" << std::endl;
+                std::cout << " - dumpcompress => deflates the dump chunks, false keeps them mappable (DEFAULT = true)" << std::endl;
+                std::cout << " - stream     => writes the lines to path (.exr or .raw) as they are rendered (DEFAULT = false)" << std::endl;
+                std::cout << " - torchmodel => TorchScript model of the torch aggregation" << std::endl;
+                std::cout << " - denoise    => TorchScript denoiser applied to the image, fed with beauty, albedo and normal (optional)" << std::endl;
+                std::cout << " - denoisethreads => intra-op threads of the denoiser (DEFAULT = threads)" << std::endl;
+                std::cout << " - denoisetile => side of the denoised tiles, bounds the inference memory (DEFAULT = 256)" << std::endl;
+                std::cout << " - runs       => eval only: independent replicas of the pixel, seeded seed, seed+1... (DEFAULT = 1)" << std::endl;
+                std::cout << " - values     => eval only: per run estimates, as text (.csv) or raw doubles (other extensions)" << std::endl;
                 return false;
             }
             if (std::regex_match(parameter, matches, pixelcam_coords)) {
@@ -218,45 +429,28 @@ protected:
 
 
 
-        // SAMPLER FACTORY INIT
-        if (sampler == "rnd") {
-            samplerFactory = std::make_shared<TrivialSamplerFactory>(spp);
-        } else if (sampler == "strat") {
-            auto sqrtSpp = static_cast<std::size_t>(sqrt(spp));
-            samplerFactory = std::make_shared<StratifiedSamplerFactory>(sqrtSpp);
-            if ((sqrtSpp * sqrtSpp) < spp) {
-                std::cout << "WARNING: spp is not a square. using spp=" << sqrtSpp * sqrtSpp << std::endl;
-            }
-            spp = sqrtSpp * sqrtSpp;
-        } else if (sampler == "sppp") {
-            samplerFactory = std::make_shared<SkewedPPPSamplerFactory>(spp, confidence);
-        }
+        samplerFactory = createSamplerFactory(sampler, spp, confidence);
+        aggregatorFactory = createAggregatorFactory(aggregator, samplerFactory, monSize, winRate, winClip, torchModel);
+        if (aggregator == "torch" && !aggregatorFactory) return false;
 
-        // AGGREGATOR FACTORY INIT
-        if (aggregator == "mc") {
-            aggregatorFactory = std::make_shared<MCAggregatorFactory>();
-        } else if (aggregator == "vor") {
-            aggregatorFactory = std::make_shared<VoronoiAggregatorFactory>();
-        } else if (aggregator == "cvor") {
-            aggregatorFactory = std::make_shared<ClippedVoronoiAggregatorFactory>();
-        } else if (aggregator == "fvor" || aggregator == "nvor") {
+        if (!denoisePath.empty()) {
+            if (stream) {
+                std::cerr << "A streamed image cannot be denoised, denoise is ignored." << std::endl;
+            } else {
+                std::size_t threads = denoiseThreads != 0 ? denoiseThreads : numThreads;
+                if (threads == 0) threads = std::thread::hardware_concurrency();
 
-            auto sampler = samplerFactory->create(0, 0);
-            auto sppp_sampler = dynamic_cast<SkewedPPPSampler*>(sampler.get());
+                try {
+                    denoiser = make_shared<Denoiser>(denoisePath, static_cast<int>(threads), denoiseTile);
+                } catch (const std::exception &e) {
+                    std::cerr << "Cannot load the denoiser " << denoisePath << ": " << e.what() << std::endl;
+                    return false;
+                }
 
-            double margin = .1;
-            if (sppp_sampler != nullptr) {
-                margin = sppp_sampler->margin;
+                // the denoiser is guided by these layers
+                for (const std::string guide : {"albedo", "normal"})
+                    if (std::find(aovs.begin(), aovs.end(), guide) == aovs.end()) aovs.push_back(guide);
             }
-
-            if (aggregator == "fvor") aggregatorFactory = std::make_shared<FilteringVoronoiAggregatorFactory>(margin);
-            if (aggregator == "nvor") aggregatorFactory = std::make_shared<NicoVoronoiAggregatorFactory>(margin);
-        } else if (aggregator == "median") {
-            aggregatorFactory = std::make_shared<MedianAggregatorFactory>();
-        } else if (aggregator == "mon") {
-            aggregatorFactory = std::make_shared<MonAggregatorFactory>(monSize);
-        } else if (aggregator == "winsor") {
-            aggregatorFactory = std::make_shared<WinsorAggregatorFactory>(winRate, winClip);
         }
 
         if (cameraType == "pixel") {
@@ -267,6 +461,8 @@ protected:
             camera = std::make_shared<BiasedForwardParallelCamera>();
         } else if (cameraType == "norm") {
             camera = std::make_shared<NormalCamera>();
+        } else if (cameraType == "wavefront") {
+            camera = std::make_shared<WavefrontCamera>();
         } else {
             camera = std::make_shared<ForwardParallelCamera>();
         }
@@ -279,6 +475,9 @@ protected:
         camera->pixelSamplerFactory = samplerFactory;
         camera->imageWidth = width;
 
+        if (const auto forward = std::dynamic_pointer_cast<ForwardCamera>(camera))
+            forward->packetSize = std::clamp<std::size_t>(packetSize, 1, RayPacket::capacity);
+
         camera->aspect_ratio   = 1.0;
         camera->background     = Color(0, 0, 0);
         camera->vfov           = 40;
@@ -287,9 +486,18 @@ protected:
         camera->vup            = Vec3(0, 1, 0);
         camera->defocusAngle   = 0;
         camera->seed           = seed;
-
-        // Set the sampling strategy based on nee flag
-        if (nee) {
+        camera->aovs           = aovs;
+
+        // Set the sampling strategy based on guiding and nee flags
+        // only the cameras that train before rendering can guide their paths, the others would trace the training
+        // passes for nothing
+        const bool guides = cameraType != "wavefront" && cameraType != "single";
+        if (guidingPasses > 0 && !guides)
+            std::cerr << "The " << cameraType << " camera does not guide its paths, guiding is ignored." << std::endl;
+
+        if (guidingPasses > 0 && guides) {
+            camera->samplingStrategy = make_shared<GuidedSamplingStrategy>(nee, guidingPasses);
+        } else if (nee) {
             camera->samplingStrategy = make_shared<NEESamplingStrategy>();
         } else {
             camera->samplingStrategy = make_shared<MixtureSamplingStrategy>();
@@ -308,10 +516,11 @@ protected:
 #ifdef FUNCTION_PARSING
         else if (source.extension() == ".func") {
 
-            camera = std::make_shared<FunctionCamera>(Function::from_file(source.string()));
+            camera = std::make_shared<FunctionCamera>(Function::from_file(source.string(), jit));
             camera->background = Color(0., .0, .0);
             camera->aspect_ratio = 1.;
             camera->seed = seed;
+            camera->aovs = aovs;
             camera->numThreads = numThreads;
             camera->maxDepth = maxDepth;
             camera->samplerAggregator = aggregatorFactory;
@@ -324,24 +533,44 @@ protected:
             return false;
         }
 
+        // LIGHT SAMPLER INIT
+        if (lightSamplerType == "uniform") {
+            lightSampler = make_shared<UniformLightSampler>(lights);
+        } else if (lightSamplerType == "bvh") {
+            lightSampler = make_shared<LightBVH>(lights);
+        } else {
+            lightSampler = make_shared<PowerLightSampler>(lights);
+        }
+
         scene.camera = camera;
         scene.lights = lights;
+        scene.lightSampler = lightSampler;
         scene.content = content;
 
+        if (!dumpPath.empty()) {
+            const auto dump = make_shared<SampleDump>(dumpPath, dumpCompress);
+            if (dumpRegion.size() == 4)
+                dump->select(dumpRegion[0], dumpRegion[1], dumpRegion[2], dumpRegion[3]);
+            else if (!dumpRegion.empty())
+                std::cerr << "dumpregion expects x0,y0,x1,y1, dumping the whole image." << std::endl;
+            camera->sampleDump = dump;
+        }
+
+        if (stream && !streamImage(argc, argv, scene)) return false;
+
         return true;
     }
 
-    bool exportImage(const int argc, char* argv[], const Scene& scene) const {
-
+    /**
+     * Output path of the image: path=, or a name built from the render settings in dir=
+     */
+    std::filesystem::path outputPath(const int argc, char* argv[]) const {
         std::filesystem::path dir;
         std::filesystem::path path;
 
         const std::string pathprefix = "path=";
         const std::string dirprefix = "dir=";
 
-        const std::regex coords(R"(cam=pixel-([0-9]+),([0-9]+))");
-        std::smatch matches;
-
         for (int i = 1 ; i < argc ; i++) {
             std::string parameter(argv[i]);
 
@@ -365,11 +594,73 @@ protected:
             path /= filename;
         }
 
+        return path;
+    }
+
+    /**
+     * Streams the lines of the image to the output path while rendering (parallel cameras only)
+     */
+    bool streamImage(const int argc, char* argv[], const Scene& scene) const {
+        if (!std::dynamic_pointer_cast<ForwardParallelCamera>(scene.camera)) {
+            std::cerr << "This camera cannot stream its image, it is kept in memory." << std::endl;
+            return true;
+        }
+
+        const std::filesystem::path path = outputPath(argc, argv);
+        const std::string destination_extension = path.extension();
+
+        if (destination_extension == ".exr") {
+            scene.camera->tileSink = make_shared<EXRTileSink>(path.string(), halfChannels, compression, tileSize,
+                                                              static_cast<int>(numThreads));
+        } else if (destination_extension == ".raw") {
+            scene.camera->tileSink = make_shared<RawTileSink>(path);
+        } else {
+            std::cerr << "Unrecognized streaming extension: \"" << destination_extension << "\"." << std::endl << "Terminating." << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    bool exportImage(const int argc, char* argv[], const Scene& scene) const {
+
+        const std::filesystem::path path = outputPath(argc, argv);
+
+        if (scene.camera->sampleDump) {
+            scene.camera->sampleDump->close();
+            std::cout << "Samples dumped to: " << dumpPath << std::endl;
+        }
+
+        if (scene.camera->tileSink) {
+            std::cout << "Rendering duration: " << static_cast<double>(render_time.count()) / 1000. << " s" << std::endl;
+            std::cout << "Image streamed to: " << path << std::endl;
+            return true;
+        }
+
+        if (denoiser) {
+            const auto denoise_start = std::chrono::system_clock::now();
+            try {
+                if (denoiser->denoise(*scene.camera->data())) {
+                    const auto denoise_time = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::system_clock::now() - denoise_start);
+                    std::cout << "Denoising duration: " << static_cast<double>(denoise_time.count()) / 1000. << " s" << std::endl;
+                }
+            } catch (const std::exception &e) {
+                // the render is not lost to a failing model: the noisy image is exported
+                std::cerr << "Denoising failed, the image is kept as rendered: " << e.what() << std::endl;
+            }
+        }
+
         std::shared_ptr<ImageExporter> exporter;
         std::string destination_extension = path.extension();
 
         if (destination_extension == ".exr") {
-            exporter = make_shared<EXRImageExporter>(scene.camera->data());
+            const auto exr = make_shared<EXRImageExporter>(scene.camera->data());
+            exr->halfChannels = halfChannels;
+            exr->compression = compression;
+            exr->tileSize = tileSize;
+            exr->numThreads = static_cast<int>(numThreads);
+            exporter = exr;
         } else if (destination_extension == ".png") {
             exporter = make_shared<PNGImageExporter>(scene.camera->data());
         }
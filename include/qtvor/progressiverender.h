@@ -0,0 +1,219 @@
+/*
+ * This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
+ * Copyright (c) 2025 PrISE-3D.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * --- ADDITIONAL PERMISSION UNDER GNU GPL VERSION 3 SECTION 7 ---
+ *
+ * If you modify this Program, or any covered work, by linking or
+ * combining it with the Intel Math Kernel Library (MKL) (or a modified
+ * version of that library), containing parts covered by the terms of
+ * the Intel Simplified Software License, the licensors of this
+ * Program grant you additional permission to convey the resulting work.
+ */
+
+#ifndef PROGRESSIVERENDER_H
+#define PROGRESSIVERENDER_H
+
+#include <QGraphicsPixmapItem>
+#include <QImage>
+#include <QTimer>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "parser.h"
+#include "utils.h"
+
+/**
+ * Renders a scene on a background thread, the camera spreading the lines over its own threads, and refreshes a
+ * pixmap item with the completed lines at a capped rate. Rendering can be cancelled and restarted, with another spp
+ * if needed, without reloading the scene.
+ */
+class ProgressiveRender {
+public:
+    ProgressiveRender(Parser &parser, Scene &yaptScene, QGraphicsPixmapItem *item, const int refreshMs = 100):
+        parser(parser), yaptScene(yaptScene), item(item) {
+        QObject::connect(&timer, &QTimer::timeout, [this] { refresh(); });
+        timer.start(refreshMs);
+    }
+
+    ~ProgressiveRender() {
+        cancel();
+    }
+
+    ProgressiveRender(const ProgressiveRender &) = delete;
+    ProgressiveRender &operator=(const ProgressiveRender &) = delete;
+
+    /**
+     * Starts the render from scratch, cancelling the running one
+     */
+    void start() {
+        cancel();
+
+        // the camera stays held until render has initialized it again and trained its strategy
+        const auto &camera = yaptScene.camera;
+        if (onCameraChanging) {
+            onCameraChanging();
+            holding = true;
+        }
+        camera->initialize();
+        const auto data = camera->data();
+
+        image = QImage(static_cast<int>(data->width), static_cast<int>(data->height), QImage::Format_RGB32);
+        image.fill(Qt::black);
+        item->setPixmap(QPixmap::fromImage(image));
+
+        {
+            std::lock_guard lock(mutex);
+            completed.clear();
+        }
+
+        camera->onLinesRendered = [this](const size_t first_row, const size_t rows) {
+            std::lock_guard lock(mutex);
+            completed.emplace_back(first_row, rows);
+        };
+
+        camera->onPrepared = [this] { prepared = true; };
+
+        camera->cancelled = false;
+        prepared = false;
+        finished = false;
+        started = std::chrono::steady_clock::now();
+
+        worker = std::thread([this] {
+            yaptScene.camera->render(*yaptScene.content, *yaptScene.lightSampler);
+            finished = true;
+        });
+
+        status("rendering");
+    }
+
+    /**
+     * Stops the running render, keeping the lines already completed
+     */
+    void cancel() {
+        if (!worker.joinable()) return;
+
+        yaptScene.camera->cancelled = true;
+        worker.join();
+        refresh();
+        release();
+        status("cancelled");
+    }
+
+    /**
+     * Restarts the render with another number of samples per pixel
+     */
+    void set_spp(const std::size_t spp) {
+        if (onCameraChanging) onCameraChanging();
+        cancel();
+        parser.setSPP(std::max<std::size_t>(1, spp), yaptScene);
+        start();
+        if (onCameraChanged) onCameraChanged();
+    }
+
+    [[nodiscard]] std::size_t spp() const {
+        return parser.getSPP();
+    }
+
+    [[nodiscard]] bool running() const {
+        return worker.joinable() && !finished;
+    }
+
+    /**
+     * Receives the status of the render (spp, state and elapsed time)
+     */
+    std::function<void(const QString &)> onStatus;
+
+    /**
+     * Called on the GUI thread before and after the camera is reconfigured (initialized, trained, or given other factories),
+     * so that the other readers of the camera wait meanwhile. Calls may nest.
+     */
+    std::function<void()> onCameraChanging;
+    std::function<void()> onCameraChanged;
+
+private:
+    void refresh() {
+        if (prepared) release();
+
+        std::vector<std::pair<size_t, size_t>> bands;
+        {
+            std::lock_guard lock(mutex);
+            bands.swap(completed);
+        }
+
+        if (!bands.empty()) {
+            const auto data = yaptScene.camera->data();
+            const size_t width = data->width;
+
+            // only the completed bands: the lines between them may still be written by the render threads
+            for (const auto &[first_row, rows] : bands) {
+                for (size_t y = first_row; y < first_row + rows; ++y) {
+                    auto *line = reinterpret_cast<QRgb *>(image.scanLine(static_cast<int>(y)));
+                    for (size_t x = 0; x < width; ++x) {
+                        const size_t index = 3 * (y * width + x);
+                        line[x] = toQColor(data->data[index], data->data[index + 1], data->data[index + 2]).rgb();
+                    }
+                }
+            }
+
+            item->setPixmap(QPixmap::fromImage(image));
+        }
+
+        if (finished && worker.joinable()) {
+            worker.join();
+            release();
+            status("done");
+        }
+    }
+
+    /**
+     * Ends the hold taken by start on the camera
+     */
+    void release() {
+        if (!holding) return;
+
+        holding = false;
+        if (onCameraChanged) onCameraChanged();
+    }
+
+    void status(const char *state) const {
+        if (!onStatus) return;
+
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+        onStatus(QString("QtVor - %1 spp - %2 (%3 s)").arg(parser.getSPP()).arg(state).arg(elapsed.count(), 0, 'f', 1));
+    }
+
+    Parser &parser;
+    Scene &yaptScene;
+    QGraphicsPixmapItem *item;
+    QTimer timer;
+    QImage image;
+
+    std::thread worker;
+    std::atomic<bool> finished{false};
+    std::atomic<bool> prepared{false};
+    bool holding = false;
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+
+    // bands (first row, rows) completed since the last refresh
+    std::mutex mutex;
+    std::vector<std::pair<size_t, size_t>> completed;
+};
+
+#endif //PROGRESSIVERENDER_H
@@ -37,6 +37,8 @@
 #include <QMouseEvent>
 #include <QWidget>
 #include <QScrollBar>
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
 
 // Forward declaration
 class CustomTableWidget;
@@ -49,23 +51,12 @@ public:
         : QGraphicsPolygonItem(polygon, parent),
           sitePoint(site),
           ellipseDiameter(ellipseDiameter),
+          ellipseItem(nullptr),
           rowIndex(rowIndex),
           tableWidget(table) {
         setBrush(brush);
         setAcceptHoverEvents(true);
         setCursor(Qt::PointingHandCursor);
-
-        const qreal ellipseRadius = ellipseDiameter / 2.0;
-        ellipseItem = new QGraphicsEllipseItem(site.x() - ellipseRadius,
-                                               site.y() - ellipseRadius,
-                                               ellipseDiameter,
-                                               ellipseDiameter,
-                                               this);
-        ellipseItem->setBrush(QBrush(Qt::white));
-        QPen sitePen(Qt::black);
-        sitePen.setWidthF(0.001);
-        ellipseItem->setPen(sitePen);
-        ellipseItem->setVisible(false);
     }
 
     void saveOriginalPen() {
@@ -74,11 +65,46 @@ public:
 
     void showSite(bool show);
 
+    /**
+     * Level of detail: cells smaller than a couple of device pixels are painted as plain boxes without outline,
+     * which keeps pixels with thousands of cells interactive when zoomed out
+     */
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override {
+        const qreal lod = option->levelOfDetailFromTransform(painter->worldTransform());
+        const QRectF bounds = boundingRect();
+
+        if (lod * std::max(bounds.width(), bounds.height()) < 2.) {
+            painter->fillRect(bounds, brush());
+            return;
+        }
+
+        QGraphicsPolygonItem::paint(painter, option, widget);
+    }
+
 protected:
     void hoverEnterEvent(QGraphicsSceneHoverEvent *event) override;
     void hoverLeaveEvent(QGraphicsSceneHoverEvent *event) override;
 
 private:
+    // the site marker is only created once shown
+    void setSiteVisible(const bool visible) {
+        if (!ellipseItem) {
+            if (!visible) return;
+
+            const qreal ellipseRadius = ellipseDiameter / 2.0;
+            ellipseItem = new QGraphicsEllipseItem(sitePoint.x() - ellipseRadius,
+                                                   sitePoint.y() - ellipseRadius,
+                                                   ellipseDiameter,
+                                                   ellipseDiameter,
+                                                   this);
+            ellipseItem->setBrush(QBrush(Qt::white));
+            QPen sitePen(Qt::black);
+            sitePen.setWidthF(0.001);
+            ellipseItem->setPen(sitePen);
+        }
+        ellipseItem->setVisible(visible);
+    }
+
     QPen originalPen;
     QPointF sitePoint;
     qreal ellipseDiameter;
@@ -153,7 +179,8 @@ private:
         if (row != lastHoveredRow) {
             // Remove red border from previous row
             if (lastHoveredRow >= 0) {
-                for (int col = 0; col < columnCount(); ++col) {
+                // the color column keeps its background
+                for (int col = 1; col < columnCount(); ++col) {
                     QTableWidgetItem* prevItem = item(lastHoveredRow, col);
                     if (prevItem) {
                         prevItem->setBackground(QBrush());
@@ -248,9 +275,7 @@ private:
 
 // VoronoiCellItem method implementations (must be after CustomTableWidget definition)
 inline void VoronoiCellItem::showSite(bool show) {
-    if (ellipseItem) {
-        ellipseItem->setVisible(show);
-    }
+    setSiteVisible(show);
 
     // Also highlight the border
     if (show) {
@@ -266,9 +291,7 @@ inline void VoronoiCellItem::hoverEnterEvent(QGraphicsSceneHoverEvent *event) {
     QGraphicsPolygonItem::hoverEnterEvent(event);
 
     // Show the site point
-    if (ellipseItem) {
-        ellipseItem->setVisible(true);
-    }
+    setSiteVisible(true);
 
     // Highlight the border with a thicker red pen
     QPen highlightPen(Qt::red);
@@ -293,9 +316,7 @@ inline void VoronoiCellItem::hoverLeaveEvent(QGraphicsSceneHoverEvent *event) {
     QGraphicsPolygonItem::hoverLeaveEvent(event);
 
     // Hide the site point
-    if (ellipseItem) {
-        ellipseItem->setVisible(false);
-    }
+    setSiteVisible(false);
 
     // Restore the original border
     setPen(originalPen);
@@ -306,46 +327,97 @@ inline void VoronoiCellItem::hoverLeaveEvent(QGraphicsSceneHoverEvent *event) {
     }
 }
 
-inline void displayVoronoi(Scene yaptScene, int x, int y) {
-    auto ag = yaptScene.camera->render_pixel(*yaptScene.content, *yaptScene.lights, y, x);
+/**
+ * Everything shown by the inspection of a pixel, computed away from the GUI thread
+ */
+struct VoronoiInspection {
+    struct Site {
+        double x;
+        double y;
+        std::vector<QPointF> cell;  // empty for the sites outside the pixel
+    };
+
+    int x;
+    int y;
+    std::vector<Site> sites;        // in Delaunay vertex order
+    std::vector<Color> contributions;
+    std::vector<double> weights;
+};
+
+/**
+ * Samples and aggregates a pixel again, without touching the rendered image, and extracts its Voronoi diagram
+ * @return the inspection, or nullptr when the pixel is not aggregated by a Voronoi diagram
+ */
+inline std::shared_ptr<VoronoiInspection> inspect_pixel(const Scene &yaptScene, const int x, const int y) {
+    const auto &camera = yaptScene.camera;
+    auto ag = camera->sample_pixel(*yaptScene.content, *yaptScene.lightSampler, y, x,
+                                   static_cast<uint32_t>(camera->seed));
 
     auto aggregator = std::dynamic_pointer_cast<VoronoiAggregator>(ag);
 
     if (aggregator == nullptr) {
-        return;
+        return nullptr;
+    }
+
+    aggregator->aggregate();
+
+    auto inspection = std::make_shared<VoronoiInspection>();
+    inspection->x = x;
+    inspection->y = y;
+    inspection->contributions.assign(aggregator->contributions.begin(), aggregator->contributions.end());
+    inspection->weights.assign(aggregator->weights.begin(), aggregator->weights.end());
+
+    const auto &delaunay = aggregator->delaunay;
+    const auto &voronoi = aggregator->voronoi;
+
+    for (auto vertex = delaunay.vertices_begin(); vertex != delaunay.vertices_end(); ++vertex) {
+        const Point &site = vertex->point();
+        VoronoiInspection::Site inspected{site.x(), site.y(), {}};
+
+        // Sites outside the pixel - special treatment, no cell
+        if (site.x() >= -.5 && site.x() < .5 && site.y() >= -.5 && site.y() < .5) {
+            Face_handle face = voronoi.dual(vertex);
+
+            Ccb_halfedge_circulator halfEdge = face->ccb(), done(halfEdge);
+
+            do {
+                Point p = halfEdge->source()->point();
+                inspected.cell.emplace_back(p.x(), p.y());
+                ++halfEdge;
+            } while (halfEdge != done);
+        }
+
+        inspection->sites.push_back(std::move(inspected));
     }
 
-    auto delaunay = aggregator->delaunay;
-    auto voronoi = aggregator->voronoi;
+    return inspection;
+}
+
+inline void showVoronoi(const VoronoiInspection &inspection) {
+    const int x = inspection.x;
+    const int y = inspection.y;
 
     // Create the table first so we can pass it to VoronoiCellItem
-    size_t size = aggregator->_samples.size();
+    size_t size = inspection.sites.size();
     auto *table = new CustomTableWidget(size, 7);
     table->setHorizontalHeaderLabels({"Color", "Site x", "Site y", "R",
                                   "G", "B", "Area"});
 
-    // Populate the table
+    // Populate the table, the color cells being plain items: thousands of widgets would stall the view
     size_t row = 0;
-    for (auto vertex = delaunay.vertices_begin(); vertex != delaunay.vertices_end(); ++vertex) {
-        Point p = vertex->point();
+    for (const auto &site : inspection.sites) {
+        Color contribution = inspection.contributions[row];
 
-        Color contribution = aggregator->contributions[row];
+        auto *colorItem = new QTableWidgetItem();
+        colorItem->setBackground(QBrush(toQColor(contribution)));
+        table->setItem(row, 0, colorItem);
 
-        // Create a colored widget for the first column
-        QWidget *colorWidget = new QWidget();
-        QColor cellColor = toQColor(contribution);
-        colorWidget->setStyleSheet(QString("background-color: rgb(%1, %2, %3);")
-                                    .arg(cellColor.red())
-                                    .arg(cellColor.green())
-                                    .arg(cellColor.blue()));
-        table->setCellWidget(row, 0, colorWidget);
-
-        table->setItem(row, 1, new QTableWidgetItem(QString::number(p.x(), 'f', 5)));
-        table->setItem(row, 2, new QTableWidgetItem(QString::number(p.y(), 'f', 5)));
+        table->setItem(row, 1, new QTableWidgetItem(QString::number(site.x, 'f', 5)));
+        table->setItem(row, 2, new QTableWidgetItem(QString::number(site.y, 'f', 5)));
         table->setItem(row, 3, new QTableWidgetItem(QString::number(contribution.x(), 'f', 5)));
         table->setItem(row, 4, new QTableWidgetItem(QString::number(contribution.y(), 'f', 5)));
         table->setItem(row, 5, new QTableWidgetItem(QString::number(contribution.z(), 'f', 5)));
-        table->setItem(row, 6, new QTableWidgetItem(QString::number(aggregator->weights[row], 'f', 5)));
+        table->setItem(row, 6, new QTableWidgetItem(QString::number(inspection.weights[row], 'f', 5)));
         ++row;
     }
 
@@ -367,14 +439,13 @@ inline void displayVoronoi(Scene yaptScene, int x, int y) {
     pointPen.setWidthF(.0025);
 
     size_t idx = 0;
-    for (auto vertex = delaunay.vertices_begin(); vertex != delaunay.vertices_end(); ++vertex) {
+    for (const auto &site : inspection.sites) {
         constexpr qreal ellipse_diameter = .01;
-        Point &site = vertex->point();
 
         // Sites outside the pixel - special treatment, no table row
-        if (site.x() < -.5 || site.x() >= .5 || site.y() < -.5 || site.y() >= .5) {
-            auto ellipseItem = new QGraphicsEllipseItem(site.x() - ellipse_diameter / 2,
-                                       site.y() - ellipse_diameter / 2,
+        if (site.cell.empty()) {
+            auto ellipseItem = new QGraphicsEllipseItem(site.x - ellipse_diameter / 2,
+                                       site.y - ellipse_diameter / 2,
                                        ellipse_diameter,
                                        ellipse_diameter);
 
@@ -386,23 +457,11 @@ inline void displayVoronoi(Scene yaptScene, int x, int y) {
             continue;
         }
 
-        Face_handle face = voronoi.dual(vertex);
-
-        Ccb_halfedge_circulator halfEdge = face->ccb(), done(halfEdge);
-
-        std::vector<QPointF> polygon;
-
-        do {
-            Point p = halfEdge->source()->point();
-            polygon.emplace_back(p.x(), p.y());
-            ++halfEdge;
-        } while (halfEdge != done);
-
-        auto qPolygon = QPolygonF(QVector<QPointF>(polygon.begin(), polygon.end()));
+        auto qPolygon = QPolygonF(QVector<QPointF>(site.cell.begin(), site.cell.end()));
 
         auto *cellItem = new VoronoiCellItem(
-            qPolygon, QBrush(toQColor(aggregator->contributions[idx])),
-            QPointF(site.x(), site.y()),
+            qPolygon, QBrush(toQColor(inspection.contributions[idx])),
+            QPointF(site.x, site.y),
             ellipse_diameter, idx, table);
         cellItem->setPen(voronoiPen);
         cellItem->saveOriginalPen();  // Save the pen AFTER setting it
@@ -421,6 +480,8 @@ inline void displayVoronoi(Scene yaptScene, int x, int y) {
     QGraphicsView *popupView = new ZoomableGraphicsView();
     popupView->setScene(qScene);
     popupView->setRenderHint(QPainter::Antialiasing);
+    popupView->setOptimizationFlag(QGraphicsView::DontSavePainterState);
+    popupView->setViewportUpdateMode(QGraphicsView::SmartViewportUpdate);
     popupView->fitInView(QRectF(-0.55, -0.55, 1.1, 1.1), Qt::KeepAspectRatio);
 
     popupView->setDragMode(QGraphicsView::ScrollHandDrag);
@@ -0,0 +1,207 @@
+/*
+ * This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
+ * Copyright (c) 2025 PrISE-3D.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * --- ADDITIONAL PERMISSION UNDER GNU GPL VERSION 3 SECTION 7 ---
+ *
+ * If you modify this Program, or any covered work, by linking or
+ * combining it with the Intel Math Kernel Library (MKL) (or a modified
+ * version of that library), containing parts covered by the terms of
+ * the Intel Simplified Software License, the licensors of this
+ * Program grant you additional permission to convey the resulting work.
+ */
+
+#ifndef VORONOIINSPECTOR_H
+#define VORONOIINSPECTOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <tuple>
+
+#include <QObject>
+
+#include "scene.h"
+#include "voronoicellitem.h"
+
+/**
+ * Computes pixel inspections on a worker thread and shows them once ready. The last inspected pixels are kept in an
+ * LRU cache keyed by pixel and seed, which is dropped whenever the camera gets other sampling factories. The worker
+ * reads the camera: it must be paused while the camera is reconfigured.
+ */
+class VoronoiInspector {
+public:
+    explicit VoronoiInspector(Scene yaptScene, const std::size_t capacity = 16):
+        yaptScene(std::move(yaptScene)), capacity(capacity), worker([this] { run(); }) {}
+
+    ~VoronoiInspector() {
+        {
+            std::lock_guard lock(mutex);
+            stopping = true;
+        }
+        available.notify_all();
+        worker.join();
+    }
+
+    VoronoiInspector(const VoronoiInspector &) = delete;
+    VoronoiInspector &operator=(const VoronoiInspector &) = delete;
+
+    /**
+     * Shows the inspection of a pixel, at once when cached, else when the worker has computed it (GUI thread only)
+     */
+    void inspect(const int x, const int y) {
+        synchronize();
+
+        const Key key{x, y, yaptScene.camera->seed};
+
+        if (const auto found = index.find(key); found != index.end()) {
+            lru.splice(lru.begin(), lru, found->second);
+            showVoronoi(*found->second->second);
+            return;
+        }
+
+        if (!pending.insert(key).second) return;
+
+        {
+            std::lock_guard lock(mutex);
+            requests.push_back({key, generation});
+        }
+        available.notify_one();
+    }
+
+    /**
+     * Waits for the running inspection and holds the next ones, before the camera is modified (GUI thread only).
+     * Pauses nest, each one is ended by resume.
+     */
+    void pause() {
+        std::unique_lock lock(mutex);
+        ++pauses;
+        idle.wait(lock, [this] { return !busy; });
+    }
+
+    /**
+     * Lets the worker go on once the camera is consistent again, the cache is dropped if its factories changed
+     */
+    void resume() {
+        synchronize();
+        {
+            std::lock_guard lock(mutex);
+            --pauses;
+        }
+        available.notify_one();
+    }
+
+private:
+    using Key = std::tuple<int, int, long>;
+    using Entry = std::pair<Key, std::shared_ptr<const VoronoiInspection>>;
+
+    struct Request {
+        Key key;
+        std::size_t generation;
+    };
+
+    // drops the cache and outdates the requests in flight when the camera has other sampling factories
+    void synchronize() {
+        const auto &camera = yaptScene.camera;
+        if (camera->pixelSamplerFactory == samplerFactory && camera->samplerAggregator == aggregatorFactory)
+            return;
+
+        lru.clear();
+        index.clear();
+        pending.clear();
+        samplerFactory = camera->pixelSamplerFactory;
+        aggregatorFactory = camera->samplerAggregator;
+        ++generation;
+    }
+
+    void run() {
+        while (true) {
+            Request request;
+            {
+                std::unique_lock lock(mutex);
+                available.wait(lock, [this] { return stopping || (pauses == 0 && !requests.empty()); });
+                if (stopping) return;
+
+                request = requests.front();
+                requests.pop_front();
+                busy = true;
+            }
+
+            // requests of an older generation are dropped by store, there is no need to compute them
+            std::shared_ptr<const VoronoiInspection> inspection;
+            if (request.generation == generation)
+                inspection = inspect_pixel(yaptScene, std::get<0>(request.key), std::get<1>(request.key));
+
+            {
+                std::lock_guard lock(mutex);
+                busy = false;
+            }
+            idle.notify_all();
+
+            // back on the GUI thread, unless the inspector is gone meanwhile
+            QMetaObject::invokeMethod(&context, [this, request, inspection] { store(request, inspection); },
+                                      Qt::QueuedConnection);
+        }
+    }
+
+    void store(const Request &request, const std::shared_ptr<const VoronoiInspection> &inspection) {
+        // computed for factories that are gone: the key may be pending again for the current ones
+        if (request.generation != generation) return;
+
+        pending.erase(request.key);
+        if (!inspection) return;
+
+        lru.emplace_front(request.key, inspection);
+        index[request.key] = lru.begin();
+
+        if (lru.size() > capacity) {
+            index.erase(lru.back().first);
+            lru.pop_back();
+        }
+
+        showVoronoi(*inspection);
+    }
+
+    Scene yaptScene;
+    std::size_t capacity;
+
+    // GUI thread only
+    std::list<Entry> lru;   // most recently used first
+    std::map<Key, std::list<Entry>::iterator> index;
+    std::set<Key> pending;
+    std::shared_ptr<SamplerFactory> samplerFactory;
+    std::shared_ptr<AggregatorFactory> aggregatorFactory;
+    QObject context;
+
+    // written by the GUI thread, read by the worker
+    std::atomic<std::size_t> generation{0};
+
+    // requests for the worker
+    std::deque<Request> requests;
+    std::mutex mutex;
+    std::condition_variable available;
+    std::condition_variable idle;
+    std::size_t pauses = 0;
+    bool busy = false;
+    bool stopping = false;
+
+    std::thread worker;
+};
+
+#endif //VORONOIINSPECTOR_H
@@ -25,21 +25,59 @@
 #ifndef ZOOMABLEIMAGEVIEW_H
 #define ZOOMABLEIMAGEVIEW_H
 #include <QApplication>
+#include <QKeyEvent>
 #include <qgraphicsitem.h>
 
 #include "scene.h"
 #include "zoomablegraphicsview.h"
 #include "voronoicellitem.h"
+#include "voronoiinspector.h"
+#include "progressiverender.h"
 
 class ZoomableImageView : public ZoomableGraphicsView {
 public:
     explicit ZoomableImageView(Scene yaptScene, QWidget *parent = nullptr): ZoomableGraphicsView(parent),
-                                                                            yaptScene(yaptScene) {
+                                                                            yaptScene(yaptScene),
+                                                                            inspector(yaptScene) {
         setMouseTracking(true);
         viewport()->installEventFilter(this);
     }
 
+    /**
+     * Render driven by the keyboard: Escape cancels it, R restarts it, + and - double or halve its spp
+     */
+    void setProgressiveRender(ProgressiveRender *render) {
+        progressiveRender = render;
+        // inspections read the camera: none runs while the render reconfigures it
+        render->onCameraChanging = [this] { inspector.pause(); };
+        render->onCameraChanged = [this] { inspector.resume(); };
+    }
+
 protected:
+    void keyPressEvent(QKeyEvent *event) override {
+        if (progressiveRender) {
+            switch (event->key()) {
+                case Qt::Key_Escape:
+                    progressiveRender->cancel();
+                    return;
+                case Qt::Key_R:
+                    progressiveRender->start();
+                    return;
+                case Qt::Key_Plus:
+                case Qt::Key_Equal:
+                    progressiveRender->set_spp(2 * progressiveRender->spp());
+                    return;
+                case Qt::Key_Minus:
+                    progressiveRender->set_spp(progressiveRender->spp() / 2);
+                    return;
+                default:
+                    break;
+            }
+        }
+
+        ZoomableGraphicsView::keyPressEvent(event);
+    }
+
     void mousePressEvent(QMouseEvent *event) override {
         if (event->button() == Qt::LeftButton && (event->modifiers() & Qt::ControlModifier)) {
             const QPointF scenePos = mapToScene(event->pos());
@@ -53,7 +91,7 @@ protected:
                     const int y = static_cast<int>(localPos.y());
 
                     if (x >= 0 && y >= 0 && x < pixmapItem->pixmap().width() && y < pixmapItem->pixmap().height()) {
-                        displayVoronoi(yaptScene, x, y);
+                        inspector.inspect(x, y);
                     }
 
                     return;
@@ -94,6 +132,8 @@ protected:
     }
 
     Scene yaptScene;
+    VoronoiInspector inspector;
+    ProgressiveRender *progressiveRender = nullptr;
 };
 
 inline QImage convertToQImage(const ImageData &imageData) {
@@ -27,11 +27,12 @@
 
 #include "yapt.h"
 #include "hittable.h"
+#include "material.h"
 
 class Quad : public Hittable {
 public:
     Quad(const Point3& Q, const Vec3& u, const Vec3& v, shared_ptr<Material> mat)
-            : Q(Q), u(u), v(v), mat(mat)
+            : Q(Q), u(u), v(v), mat(mat), mat_id(MaterialTable::add(mat))
     {
         auto n = cross(u, v);
         normal = unit_vector(n);
@@ -40,6 +41,9 @@ public:
 
         area = n.length();
 
+        // spherical rectangle sampling needs orthogonal edges
+        rectangle = fabs(dot(u, v)) < 1e-8 * u.length() * v.length();
+
         setBoundingBox();
     }
 
@@ -75,14 +79,18 @@ public:
 
         // Ray hits the 2D shape; set the rest of the hit record and return true.
         rec.t = t;
-        rec.p = intersection;
-
-        rec.mat = mat;
-        rec.set_face_normal(r, normal);
+        rec.mat_id = mat_id;
+        rec.light_id = light_id;
+        rec.deferred = this;
 
         return true;
     }
 
+    void finalize(const Ray& r, HitRecord& rec) const override {
+        rec.p = r.at(rec.t);
+        rec.set_face_normal(r, normal);
+    }
+
     virtual bool isInterior(double a, double b, HitRecord& rec) const {
         auto unit_interval = Interval(0, 1);
         // Given the hit point in plane coordinates, return false if it is outside the
@@ -101,26 +109,173 @@ public:
         if (!this->hit(Ray(origin, direction), Interval(0.001, infinity), rec))
             return 0;
 
-        const auto distance_squared = rec.t * rec.t * direction.length2();
-        const auto cosine = fabs(dot(direction, rec.normal) / direction.length());
+        return sampling_pdf(origin, direction, rec);
+    }
 
-        return distance_squared / (cosine * area);
+    [[nodiscard]] double pdfValue(const Point3& origin, const Vec3& direction, const HitRecord& rec) const override {
+        if (light_id < 0)
+            return pdfValue(origin, direction);
+
+        // the hit is already known: no need to intersect again
+        if (rec.light_id != light_id)
+            return 0;
+
+        return sampling_pdf(origin, direction, rec);
     }
 
     [[nodiscard]] Vec3 random(const Point3& origin) const override {
+        SphericalRectangle rect;
+        if (sampling == LightSampling::SolidAngle && spherical_rectangle(origin, rect))
+            return rect.sample(random_double(), random_double());
+
         auto p = Q + (random_double() * u) + (random_double() * v);
         return p - origin;
     }
 
+    void set_light_sampling(const LightSampling s) override {
+        sampling = s;
+    }
+
+    [[nodiscard]] double power() const override {
+        return mat ? luminance(mat->emission()) * area : 0.0;
+    }
+
+    [[nodiscard]] LightBounds light_bounds() const override {
+        // lights only emit on their front face, in the hemisphere around the normal
+        return {bbox, normal, power(), 1, 0, false};
+    }
+
 private:
     Point3 Q;
     Vec3 u, v;
     Vec3 w;
     shared_ptr<Material> mat;
+    uint32_t mat_id;
     AABB bbox;
     Vec3 normal;
     double D;
     double area;
+    bool rectangle;
+    LightSampling sampling = LightSampling::Area;
+
+    /**
+     * The rectangle as seen from an origin, in the local frame of Ureña et al., "An Area-Preserving
+     * Parametrization for Spherical Rectangles" (2013). The origin is at (0, 0, 0) and the rectangle lies
+     * in the plane z = z0 < 0, spanning [x0, x1] x [y0, y1]
+     */
+    struct SphericalRectangle {
+        Vec3 x, y, z;
+        double x0, x1, y0, y1, z0;
+        double b0, b1, k;
+        double solid_angle;
+
+        /**
+         * Maps uniform numbers to a direction uniformly distributed in the solid angle of the rectangle
+         * @return a vector from the origin to the sampled point of the rectangle
+         */
+        [[nodiscard]] Vec3 sample(const double s, const double t) const {
+            // find the x coordinate of the point for the sampled sub solid angle
+            const auto au = s * solid_angle + k;
+            const auto fu = (cos(au) * b0 - b1) / sin(au);
+            auto cu = 1 / sqrt(fu * fu + b0 * b0) * (fu > 0 ? 1 : -1);
+            cu = Interval(-1, 1).clamp(cu);
+            auto xu = -(cu * z0) / fmax(sqrt(1 - cu * cu), 1e-12);
+            xu = Interval(x0, x1).clamp(xu);
+
+            // then its y coordinate, uniform in the height of the spherical segment
+            const auto d = sqrt(xu * xu + z0 * z0);
+            const auto h0 = y0 / sqrt(d * d + y0 * y0);
+            const auto h1 = y1 / sqrt(d * d + y1 * y1);
+            const auto hv = h0 + t * (h1 - h0);
+            const auto hv2 = hv * hv;
+            const auto yv = hv2 < 1 - 1e-6 ? (hv * d) / sqrt(1 - hv2) : y1;
+
+            return xu * x + yv * y + z0 * z;
+        }
+    };
+
+    /**
+     * Computes the spherical rectangle subtended by the quad from an origin
+     * @return false if the quad cannot be sampled by solid angle from the origin (not a rectangle, or solid angle
+     * outside of the stable range), in which case area sampling is used
+     */
+    bool spherical_rectangle(const Point3& origin, SphericalRectangle& rect) const {
+        if (!rectangle)
+            return false;
+
+        const auto u_length = u.length();
+        const auto v_length = v.length();
+        rect.x = u / u_length;
+        rect.y = v / v_length;
+        rect.z = cross(rect.x, rect.y);
+
+        const Vec3 d = Q - origin;
+        rect.x0 = dot(d, rect.x);
+        rect.y0 = dot(d, rect.y);
+        rect.z0 = dot(d, rect.z);
+
+        // the rectangle has to lie on the negative z side
+        if (rect.z0 > 0) {
+            rect.z = -rect.z;
+            rect.z0 = -rect.z0;
+        }
+
+        rect.x1 = rect.x0 + u_length;
+        rect.y1 = rect.y0 + v_length;
+
+        // normals of the planes containing the origin and each edge
+        const Vec3 v00(rect.x0, rect.y0, rect.z0);
+        const Vec3 v01(rect.x0, rect.y1, rect.z0);
+        const Vec3 v10(rect.x1, rect.y0, rect.z0);
+        const Vec3 v11(rect.x1, rect.y1, rect.z0);
+        const Vec3 n0 = cross(v00, v10);
+        const Vec3 n1 = cross(v10, v11);
+        const Vec3 n2 = cross(v11, v01);
+        const Vec3 n3 = cross(v01, v00);
+
+        if (n0.length2() == 0 || n1.length2() == 0 || n2.length2() == 0 || n3.length2() == 0)
+            return false;
+
+        const Vec3 m0 = unit_vector(n0);
+        const Vec3 m1 = unit_vector(n1);
+        const Vec3 m2 = unit_vector(n2);
+        const Vec3 m3 = unit_vector(n3);
+
+        // internal angles of the spherical rectangle
+        const Interval unit(-1, 1);
+        const auto g0 = acos(unit.clamp(-dot(m0, m1)));
+        const auto g1 = acos(unit.clamp(-dot(m1, m2)));
+        const auto g2 = acos(unit.clamp(-dot(m2, m3)));
+        const auto g3 = acos(unit.clamp(-dot(m3, m0)));
+
+        rect.b0 = m0.z();
+        rect.b1 = m2.z();
+        rect.k = 2 * pi - g2 - g3;
+        rect.solid_angle = g0 + g1 - rect.k;
+
+        return rect.solid_angle >= MIN_SOLID_ANGLE_SAMPLING && rect.solid_angle <= MAX_SOLID_ANGLE_SAMPLING;
+    }
+
+    /**
+     * The pdf of sampling a hit point of the quad with the sampling method of the quad
+     */
+    [[nodiscard]] double sampling_pdf(const Point3& origin, const Vec3& direction, const HitRecord& rec) const {
+        SphericalRectangle rect;
+        if (sampling == LightSampling::SolidAngle && spherical_rectangle(origin, rect))
+            return 1 / rect.solid_angle;
+
+        return area_pdf(direction, rec);
+    }
+
+    /**
+     * Converts the uniform area pdf to solid angle at a hit point
+     */
+    [[nodiscard]] double area_pdf(const Vec3& direction, const HitRecord& rec) const {
+        const auto distance_squared = rec.t * rec.t * direction.length2();
+        const auto cosine = fabs(dot(direction, normal) / direction.length());
+
+        return distance_squared / (cosine * area);
+    }
 };
 
 
@@ -33,17 +33,25 @@
  */
 class Ray {
 public:
-    Ray();
+    Ray() = default;
 
-    Ray(const Point3 &o, const Vec3 &dir);
+    Ray(const Point3 &o, const Vec3 &dir) : orig(o), dir(dir) {}
 
-    static Ray shoot(Point3 &from, Point3 &aiming);
+    static Ray shoot(const Point3 &from, const Point3 &aiming) {
+        return {from, aiming - from};
+    }
 
-    [[nodiscard]] Point3 at(double t) const;
+    [[nodiscard]] Point3 at(const double t) const {
+        return orig + t * dir;
+    }
 
-    [[nodiscard]] const Point3 &origin() const;
+    [[nodiscard]] const Point3 &origin() const {
+        return orig;
+    }
 
-    [[nodiscard]] const Vec3 &direction() const;
+    [[nodiscard]] const Vec3 &direction() const {
+        return dir;
+    }
 
 private:
     Point3 orig;
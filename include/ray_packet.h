@@ -0,0 +1,95 @@
+/*
+ * This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
+ * Copyright (c) 2025 PrISE-3D.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * --- ADDITIONAL PERMISSION UNDER GNU GPL VERSION 3 SECTION 7 ---
+ *
+ * If you modify this Program, or any covered work, by linking or
+ * combining it with the Intel Math Kernel Library (MKL) (or a modified
+ * version of that library), containing parts covered by the terms of
+ * the Intel Simplified Software License, the licensors of this
+ * Program grant you additional permission to convey the resulting work.
+ */
+
+#ifndef YAPT_RAY_PACKET_H
+#define YAPT_RAY_PACKET_H
+
+#include "yapt.h"
+#include "aabb.h"
+#include "hittable.h"
+#include <cstdint>
+
+/**
+ * A packet of coherent rays (eg. the samples of a pixel) traversing acceleration structures together.
+ * Nodes are culled for the whole packet with a conservative interval arithmetic test on the ray origins and
+ * directions, primitives are intersected ray by ray.
+ */
+class RayPacket {
+public:
+    static constexpr std::size_t capacity = 16;
+
+    Ray rays[capacity];
+    HitRecord records[capacity];  // closest hit of each ray
+    double t_max[capacity];       // distance of the closest hit of each ray so far
+    uint32_t active = 0;          // bit i is set if ray i is traced
+    std::size_t size = 0;
+
+    void clear();
+
+    /**
+     * Adds a ray to the packet
+     * @param r the ray, the packet must not be full
+     */
+    void add(const Ray &r);
+
+    /**
+     * Computes the bounds of the packet origins and directions, to be called once all rays are added
+     */
+    void prepare();
+
+    /**
+     * Conservative test of the packet against a bounding box
+     * @param box the box to test
+     * @param ray_t the interval along the rays where hits are accepted
+     * @return false only if no active ray of the packet can hit the box closer than its current closest hit
+     */
+    [[nodiscard]] bool may_hit(const AABB &box, const Interval &ray_t) const;
+
+    /**
+     * Same test against the bounds of a compact box, read as they are stored
+     */
+    [[nodiscard]] bool may_hit(const CompactAABB &box, const Interval &ray_t) const;
+
+    /**
+     * Shrinks the culling distance to the closest hits found so far, to be called whenever rays of the packet hit
+     */
+    void update_farthest();
+
+    /**
+     * Whether the packet mostly travels towards decreasing coordinates along an axis, to visit nearer nodes first
+     */
+    [[nodiscard]] bool backward(const int axis) const { return backwards[axis]; }
+
+private:
+    template<typename Box>
+    [[nodiscard]] bool may_hit_slabs(const Box &box, const Interval &ray_t) const;
+
+    Interval origins[3];             // range of the ray origins along each axis
+    Interval inverse_directions[3];  // range of the inverse ray directions along each axis
+    bool same_sign[3];               // whether the directions share a strict sign along each axis, required for culling
+    bool backwards[3];               // whether the directions sum to a negative coordinate along each axis
+    double farthest = infinity;      // largest t_max of the active rays
+};
+
+#endif //YAPT_RAY_PACKET_H
@@ -0,0 +1,130 @@
+/*
+ * This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
+ * Copyright (c) 2025 PrISE-3D.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * --- ADDITIONAL PERMISSION UNDER GNU GPL VERSION 3 SECTION 7 ---
+ *
+ * If you modify this Program, or any covered work, by linking or
+ * combining it with the Intel Math Kernel Library (MKL) (or a modified
+ * version of that library), containing parts covered by the terms of
+ * the Intel Simplified Software License, the licensors of this
+ * Program grant you additional permission to convey the resulting work.
+ */
+
+#ifndef YAPT_SAMPLE_DUMP_H
+#define YAPT_SAMPLE_DUMP_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class SampleAggregator;
+
+/**
+ * Streams the samples, contributions and aggregation weights of selected pixels to a binary file, from a background
+ * I/O thread. All values are little endian:
+ *
+ *  - file header, 16 bytes: "YAPTDUMP", uint32 version (1), uint32 flags (bit 0: chunks are zlib compressed)
+ *  - chunks, each a 32 bytes header: "CHNK", uint32 pixel count, uint64 sample count, uint64 stored payload size,
+ *    uint64 raw payload size, followed by the payload (deflated when compressed):
+ *     - the pixels, 16 bytes each: uint32 x, uint32 y, uint32 first sample in the chunk, uint32 sample count
+ *     - the samples, 32 bytes each: float64 dx, float64 dy, float32 r, g, b, float32 weight (NaN when the
+ *       aggregator has no weights)
+ *
+ * Uncompressed chunks can be mapped directly as arrays of these records.
+ */
+class SampleDump {
+public:
+    struct PixelRecord {
+        uint32_t x;
+        uint32_t y;
+        uint32_t first;
+        uint32_t count;
+    };
+
+    struct SampleRecord {
+        double dx;
+        double dy;
+        float r;
+        float g;
+        float b;
+        float weight;
+    };
+
+    static_assert(sizeof(PixelRecord) == 16 && sizeof(SampleRecord) == 32, "dump records must be packed");
+
+    /**
+     * @param path output file
+     * @param compress deflates the chunks
+     * @param chunkSamples samples gathered before a chunk is written
+     */
+    explicit SampleDump(const std::filesystem::path &path, bool compress = true, std::size_t chunkSamples = 1 << 16);
+    ~SampleDump();
+
+    SampleDump(const SampleDump &) = delete;
+    SampleDump &operator=(const SampleDump &) = delete;
+
+    /**
+     * Restricts the dump to the pixels in [x0, x1) x [y0, y1)
+     */
+    void select(std::size_t x0, std::size_t y0, std::size_t x1, std::size_t y1);
+
+    [[nodiscard]] bool selected(std::size_t row, std::size_t column) const;
+
+    /**
+     * Queues a gathered and aggregated pixel, copying its data: the aggregator may be released right after
+     */
+    void record(std::size_t row, std::size_t column, const SampleAggregator &aggregator);
+
+    /**
+     * Writes the pending pixels and closes the file, further records are ignored
+     */
+    void close();
+
+private:
+    struct Pending {
+        PixelRecord pixel;
+        std::vector<SampleRecord> samples;
+    };
+
+    void run();
+    void write_chunk();
+
+    std::ofstream out;
+    bool compress;
+    std::size_t chunkSamples;
+    std::size_t x0 = 0, y0 = 0;
+    std::size_t x1 = SIZE_MAX, y1 = SIZE_MAX;
+
+    // pixels queued by the render threads, bounded so that a slow disk throttles them instead of exhausting memory
+    std::deque<Pending> queue;
+    std::mutex mutex;
+    std::condition_variable available;
+    std::condition_variable space;
+    bool closing = false;
+    bool closed = false;
+
+    // chunk being assembled by the I/O thread
+    std::vector<PixelRecord> pixels;
+    std::vector<SampleRecord> samples;
+
+    std::thread writer;
+};
+
+#endif //YAPT_SAMPLE_DUMP_H
@@ -28,6 +28,9 @@
 #include <boost/math/tools/precision.hpp>
 
 #include "yapt.h"
+#include "arena.h"
+#include <memory_resource>
+#include <vector>
 
 struct Sample {
     double x;
@@ -51,7 +54,7 @@ public:
     double x;
     double y;
 
-    void get_samples(std::vector<Sample>& out) const {
+    void get_samples(std::pmr::vector<Sample>& out) const {
         out.clear();
         out.reserve(total_sample_count());
         generate_samples(out);
@@ -61,7 +64,7 @@ public:
     virtual std::size_t usable_sample_count() const = 0;
 
 protected:
-    virtual void generate_samples(std::vector<Sample>& out) const = 0;
+    virtual void generate_samples(std::pmr::vector<Sample>& out) const = 0;
 };
 
 class TrivialSampler: public PixelSampler {
@@ -79,7 +82,7 @@ public:
     }
 
 protected:
-    void generate_samples(std::vector<Sample> &out) const override {
+    void generate_samples(std::pmr::vector<Sample> &out) const override {
         for (std::size_t i = 0 ; i < size ; ++i) {
             const double _dx = random_double() - .5;
             const double _dy = random_double() - .5;
@@ -107,7 +110,7 @@ public:
         return sqrtSpp * sqrtSpp;
     }
 
-    void generate_samples(std::vector<Sample> &out) const override {
+    void generate_samples(std::pmr::vector<Sample> &out) const override {
         const double step = 1.0 / static_cast<double>(sqrtSpp);
         const double start_offset = -0.5;
 
@@ -146,7 +149,7 @@ class TrivialSamplerFactory: public SamplerFactory {
 public:
     explicit TrivialSamplerFactory(int samples): samples(samples) {}
     shared_ptr<PixelSampler> create(double x, double y) override {
-        return make_shared<TrivialSampler>(x, y, samples);
+        return make_pixel_shared<TrivialSampler>(x, y, samples);
     }
 
 protected:
@@ -158,7 +161,7 @@ public:
     explicit StratifiedSamplerFactory(const int sqrtSpp): sqrtSpp(sqrtSpp) {}
 
     shared_ptr<PixelSampler> create(double x, double y) override {
-        return make_shared<StratifiedSampler>(x, y, sqrtSpp);
+        return make_pixel_shared<StratifiedSampler>(x, y, sqrtSpp);
     }
 protected:
     int sqrtSpp;
@@ -181,7 +184,7 @@ public:
         return _usable_sample_count;
     }
 
-    void generate_samples(std::vector<Sample> &out) const override {
+    void generate_samples(std::pmr::vector<Sample> &out) const override {
         // inner samples
         for (size_t i = 0 ; i < _usable_sample_count ; ++i) {
             const double _dx = random_double() - .5;
@@ -239,7 +242,7 @@ public:
     }
 
     shared_ptr<PixelSampler> create(double x, double y) override {
-        return make_shared<SkewedPPPSampler>(x, y, number_of_samples, skewed_intensity, margin);
+        return make_pixel_shared<SkewedPPPSampler>(x, y, number_of_samples, skewed_intensity, margin);
     }
 
     std::size_t skewed_intensity;
@@ -28,6 +28,8 @@
 #include "yapt.h"
 #include "hittable.h"
 #include "material.h"
+#include "sd_tree.h"
+#include <atomic>
 #include <functional>
 
 class SamplingStrategy {
@@ -46,10 +48,44 @@ public:
         int remaining_depth;               // Remaining ray bounces
     };
 
+    /**
+     * Computes the light scattered at a hit point
+     * @param context the hit point and its scene
+     * @param ray_color_function gathers the light along a ray for some remaining depth, and reports the first hit of
+     * the ray in its HitRecord argument so that strategies can evaluate light pdfs without intersecting it again
+     * @return the scattered light
+     */
     virtual Color compute_scattered_color(
         const SamplingContext& context,
-        const std::function<Color(const Ray&, int)>& ray_color_function
+        const std::function<Color(const Ray&, int, HitRecord&)>& ray_color_function
     ) const = 0;
+
+    /**
+     * Passes the cameras render before the image so that the strategy learns the scene, none by default
+     */
+    [[nodiscard]] virtual std::size_t training_passes() const { return 0; }
+
+    /**
+     * Samples per pixel of a training pass
+     */
+    [[nodiscard]] virtual std::size_t training_spp(std::size_t pass) const { return 0; }
+
+    /**
+     * Called before the threads of a training pass start: the strategy learns from the light it gathers until
+     * end_pass
+     */
+    virtual void begin_pass(const Hittable& world, std::size_t pass) {}
+
+    /**
+     * Called once the threads of a training pass are done
+     */
+    virtual void end_pass(std::size_t pass) {}
+
+    /**
+     * Whether the lights are sampled at the hit points, the cameras that do not call compute_scattered_color follow
+     * this flag
+     */
+    [[nodiscard]] virtual bool uses_nee() const { return false; }
 };
 
 class NEESamplingStrategy : public SamplingStrategy {
@@ -58,8 +94,10 @@ public:
 
     Color compute_scattered_color(
         const SamplingContext& context,
-        const std::function<Color(const Ray&, int)>& ray_color_function
+        const std::function<Color(const Ray&, int, HitRecord&)>& ray_color_function
     ) const override;
+
+    [[nodiscard]] bool uses_nee() const override { return true; }
 };
 
 class MixtureSamplingStrategy : public SamplingStrategy {
@@ -68,8 +106,40 @@ public:
 
     Color compute_scattered_color(
         const SamplingContext& context,
-        const std::function<Color(const Ray&, int)>& rayColorFunc
+        const std::function<Color(const Ray&, int, HitRecord&)>& rayColorFunc
+    ) const override;
+};
+
+/**
+ * Path guiding: the scattered directions are drawn from a mixture of the bsdf and of the incident radiance learned
+ * by an SDTree during the training passes, weighted by their combined density. Passes double their samples per
+ * pixel, from 1. The lights are sampled as well when nee is set, weighted against the scattered directions with
+ * the power heuristic.
+ */
+class GuidedSamplingStrategy : public SamplingStrategy {
+public:
+    explicit GuidedSamplingStrategy(bool nee, std::size_t passes = 5);
+    ~GuidedSamplingStrategy() override = default;
+
+    Color compute_scattered_color(
+        const SamplingContext& context,
+        const std::function<Color(const Ray&, int, HitRecord&)>& ray_color_function
     ) const override;
+
+    [[nodiscard]] std::size_t training_passes() const override { return passes; }
+    [[nodiscard]] std::size_t training_spp(std::size_t pass) const override { return std::size_t{1} << pass; }
+    void begin_pass(const Hittable& world, std::size_t pass) override;
+    void end_pass(std::size_t pass) override;
+    [[nodiscard]] bool uses_nee() const override { return nee; }
+
+    // probability of following the bsdf rather than the guide where something is learned
+    double bsdfFraction = .5;
+
+private:
+    bool nee;
+    std::size_t passes;
+    std::shared_ptr<SDTree> tree;
+    std::atomic<bool> learning{false};
 };
 
 #endif //YAPT_SAMPLING_STRATEGY_H
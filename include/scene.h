@@ -28,6 +28,8 @@
 #include "yapt.h"
 #include "hittable_list.h"
 #include "camera.h"
+#include "light_sampler.h"
+#include "light_bvh.h"
 
 class Scene {
 public:
@@ -36,6 +38,7 @@ public:
     ~Scene() = default;
     std::shared_ptr<HittableList> content;
     std::shared_ptr<HittableList> lights;
+    std::shared_ptr<LightSampler> lightSampler;
     std::shared_ptr<Camera> camera;
 };
 
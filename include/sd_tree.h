@@ -0,0 +1,139 @@
+/*
+ * This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
+ * Copyright (c) 2025 PrISE-3D.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * --- ADDITIONAL PERMISSION UNDER GNU GPL VERSION 3 SECTION 7 ---
+ *
+ * If you modify this Program, or any covered work, by linking or
+ * combining it with the Intel Math Kernel Library (MKL) (or a modified
+ * version of that library), containing parts covered by the terms of
+ * the Intel Simplified Software License, the licensors of this
+ * Program grant you additional permission to convey the resulting work.
+ */
+
+#ifndef YAPT_SD_TREE_H
+#define YAPT_SD_TREE_H
+
+#include "yapt.h"
+#include "aabb.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Directional distribution of the incident radiance at a region of the scene: a quadtree over the cylindrical
+ * mapping of the sphere, (cos theta, phi) -> [0, 1]^2, which preserves areas. Each node holds the energy recorded
+ * in its four quadrants, the quadrants holding the most energy being subdivided further.
+ * Records are atomic additions: the render threads share a tree without locking it.
+ */
+class DTree {
+public:
+    DTree();
+    DTree(const DTree &other);
+    DTree &operator=(const DTree &other);
+
+    /**
+     * Adds the energy gathered from a direction, thread safe
+     */
+    void record(const Vec3 &direction, double value);
+
+    /**
+     * Draws a direction proportionally to the recorded energy, uniformly on the sphere while nothing is recorded
+     */
+    [[nodiscard]] Vec3 sample() const;
+
+    /**
+     * Solid angle density of sample
+     */
+    [[nodiscard]] double pdf(const Vec3 &direction) const;
+
+    [[nodiscard]] double total() const;
+    [[nodiscard]] std::uint64_t count() const;
+
+    /**
+     * Rebuilds the quadtree from the energy of another tree, then clears it: the quadrants holding more than
+     * fluxThreshold of the total energy are subdivided, the others are merged
+     */
+    void refine(const DTree &from, double fluxThreshold, int maxDepth);
+
+private:
+    struct Node {
+        std::array<std::atomic<double>, 4> sums;
+        std::array<std::uint32_t, 4> children;  // 0 for the quadrants without a child
+
+        Node();
+        Node(const Node &other);
+        Node &operator=(const Node &other);
+
+        [[nodiscard]] double total() const;
+    };
+
+    std::vector<Node> nodes;
+    std::atomic<std::uint64_t> records;
+};
+
+/**
+ * Spatio-directional radiance cache (Müller et al., "Practical Path Guiding for Efficient Light-Transport
+ * Simulation"): a binary tree over the scene bounds whose leaves hold directional quadtrees. It is learned by
+ * passes: during a pass the render threads record in the building trees and sample the sampling trees, which do
+ * not change; between passes, refine splits the busy leaves and the building trees become the sampling ones.
+ */
+class SDTree {
+public:
+    explicit SDTree(const AABB &bounds);
+
+    /**
+     * Records the energy gathered at a point from a direction, thread safe
+     */
+    void record(const Point3 &p, const Vec3 &direction, double value);
+
+    /**
+     * Directional distribution learned around a point
+     */
+    [[nodiscard]] const DTree &guide(const Point3 &p) const;
+
+    /**
+     * Ends a training pass, the threads being done with the tree
+     * @param pass index of the pass, the leaves are split once they hold spatialThreshold * sqrt(2^pass) records
+     */
+    void refine(std::size_t pass);
+
+    double spatialThreshold = 12000;
+    double fluxThreshold = .01;
+    int maxDirectionalDepth = 20;
+    int maxSpatialDepth = 24;
+
+private:
+    struct Node {
+        int axis;
+        std::array<std::uint32_t, 2> children;  // both 0 for a leaf
+        std::uint32_t leaf;
+    };
+
+    struct Leaf {
+        DTree building;
+        DTree sampling;
+    };
+
+    [[nodiscard]] std::uint32_t leaf_at(const Point3 &p) const;
+    void split(std::uint32_t node, double records, double threshold, int depth);
+
+    Point3 origin;
+    Vec3 extent;
+    std::vector<Node> nodes;
+    std::vector<Leaf> leaves;
+};
+
+#endif //YAPT_SD_TREE_H
@@ -31,6 +31,7 @@
 #include "yapt.h"
 #include "aabb.h"
 #include "onb.h"
+#include "material.h"
 
 
 class Sphere : public Hittable {
@@ -42,7 +43,7 @@ public:
     }
 
     Sphere(const Point3 &center, double radius, shared_ptr<Material> mat)
-            : center(center), radius(fmax(0, radius)), mat(mat) {
+            : center(center), radius(fmax(0, radius)), mat(mat), mat_id(MaterialTable::add(mat)) {
         auto rvec = Vec3(radius, radius, radius);
         bbox = AABB(center - rvec, center + rvec);
     }
@@ -68,17 +69,22 @@ public:
         }
 
         rec.t = root;
-        rec.p = r.at(rec.t);
-        const Vec3 outward_normal = (rec.p - center) / radius;
-        rec.set_face_normal(r, outward_normal);
-        get_sphere_uv(outward_normal, rec.u, rec.v);
 
         if (mat)
-            rec.mat = mat;
+            rec.mat_id = mat_id;
+        rec.light_id = light_id;
+        rec.deferred = this;
 
         return true;
     }
 
+    void finalize(const Ray &r, HitRecord &rec) const override {
+        rec.p = r.at(rec.t);
+        const Vec3 outward_normal = (rec.p - center) / radius;
+        rec.set_face_normal(r, outward_normal);
+        get_sphere_uv(outward_normal, rec.u, rec.v);
+    }
+
     [[nodiscard]] bool has(const Point3 &point) const {
         const auto r = point - center;
         const double radius2 = radius * radius;
@@ -90,14 +96,33 @@ public:
     [[nodiscard]] double pdfValue(const Point3 &origin, const Vec3 &direction) const override {
         // This method only works for stationary spheres.
 
-        HitRecord rec;
-        if (!this->hit(Ray(origin, direction), Interval(0.001, infinity), rec))
-            return 0;
+        const Vec3 to_center = center - origin;
+        const auto distance_squared = to_center.length2();
+
+        if (distance_squared <= radius * radius) {
+            HitRecord rec;
+            if (!this->hit(Ray(origin, direction), Interval(0.001, infinity), rec))
+                return 0;
+        } else {
+            // the direction reaches the sphere iff it lies in the cone subtended by the sphere: no intersection needed
+            const auto cos_theta_max = sqrt(1 - radius * radius / distance_squared);
+            const auto cosine = dot(direction, to_center) / (direction.length() * sqrt(distance_squared));
+            if (cosine < cos_theta_max)
+                return 0;
+        }
 
-        const auto cos_theta_max = sqrt(1 - radius * radius / (center - origin).length2());
-        const auto solid_angle = 2 * pi * (1 - cos_theta_max);
+        return 1 / solid_angle(origin);
+    }
+
+    [[nodiscard]] double pdfValue(const Point3 &origin, const Vec3 &direction, const HitRecord &rec) const override {
+        if (light_id < 0)
+            return pdfValue(origin, direction);
+
+        // the hit is already known: the pdf only depends on the origin
+        if (rec.light_id != light_id)
+            return 0;
 
-        return 1 / solid_angle;
+        return 1 / solid_angle(origin);
     }
 
     [[nodiscard]] Vec3 random(const Point3 &origin) const override {
@@ -108,14 +133,24 @@ public:
         return uvw.local(random_to_sphere(radius, distance_squared));
     }
 
+    [[nodiscard]] double power() const override {
+        return mat ? luminance(mat->emission()) * 4 * pi * radius * radius : 0.0;
+    }
+
 
 private:
     Point3 center;
     double radius;
     shared_ptr<Material> mat;
+    uint32_t mat_id = MaterialTable::none;
     Vec3 center_vec;
     AABB bbox;
 
+    [[nodiscard]] double solid_angle(const Point3 &origin) const {
+        const auto cos_theta_max = sqrt(1 - radius * radius / (center - origin).length2());
+        return 2 * pi * (1 - cos_theta_max);
+    }
+
     static void get_sphere_uv(const Point3 &p, double &u, double &v) {
         // p: a given point on the sphere of radius one, centered at the origin.
         // u: returned value [0,1] of angle around the Y axis from X=-1.
@@ -0,0 +1,88 @@
+/*
+ * This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
+ * Copyright (c) 2025 PrISE-3D.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * --- ADDITIONAL PERMISSION UNDER GNU GPL VERSION 3 SECTION 7 ---
+ *
+ * If you modify this Program, or any covered work, by linking or
+ * combining it with the Intel Math Kernel Library (MKL) (or a modified
+ * version of that library), containing parts covered by the terms of
+ * the Intel Simplified Software License, the licensors of this
+ * Program grant you additional permission to convey the resulting work.
+ */
+
+#ifndef YAPT_TORCH_AGGREGATOR_H
+#define YAPT_TORCH_AGGREGATOR_H
+
+#include "aggregators.h"
+#include <filesystem>
+#include <memory>
+
+class TorchAggregatorFactory;
+
+/**
+ * Monte Carlo sampling, the samples being weighted by a learned model: the color is the weighted mean of the
+ * contributions. The weights of the pixels of a line are inferred together by TorchAggregatorFactory::prepare,
+ * a pixel aggregated on its own runs a batch of one.
+ */
+class TorchAggregator: public MCSampleAggregator {
+public:
+    explicit TorchAggregator(const TorchAggregatorFactory &factory);
+    Color aggregate() override;
+
+    std::pmr::vector<double> weights{PixelArena::resource()};
+
+private:
+    const TorchAggregatorFactory &factory;
+};
+
+/**
+ * Creates TorchAggregators sharing a TorchScript model, run on the CPU. For a batch of B pixels holding at most N
+ * samples, the model receives:
+ *  - features, float32 [B, N, 5]: offset dx, dy of the sample in the pixel, then its contribution r, g, b
+ *  - mask, bool [B, N]: true for the actual samples, the features of the padding are zeros
+ * and returns the weights of the samples, [B, N], those of the padding being ignored.
+ */
+class TorchAggregatorFactory: public AggregatorFactory {
+public:
+    /**
+     * Loads the model and checks it on a small batch, throws c10::Error when it cannot be read or run, and
+     * std::invalid_argument when it does not return a weight per sample. An inference failing during the render
+     * is reported once, its pixels keep the Monte Carlo mean.
+     * @param path TorchScript module (torch.jit.save)
+     * @param numThreads intra-op threads of an inference, the render threads already run concurrently. The setting
+     * is process wide: the Denoiser, run once the image is rendered, changes it for its own inference and restores it
+     */
+    explicit TorchAggregatorFactory(const std::filesystem::path &path, int numThreads = 1);
+    ~TorchAggregatorFactory() override;
+
+    shared_ptr<SampleAggregator> create() override;
+    [[nodiscard]] bool batched() const override { return true; }
+    void prepare(const std::vector<std::shared_ptr<SampleAggregator>> &aggregators) override;
+
+    /**
+     * Infers the weights of gathered pixels in one call of the model
+     */
+    void infer(const std::vector<TorchAggregator *> &batch) const;
+
+    // pixels given to a single inference, larger batches are split
+    std::size_t batchSize = 1024;
+
+private:
+    struct Model;
+
+    std::unique_ptr<Model> model;
+};
+
+#endif //YAPT_TORCH_AGGREGATOR_H
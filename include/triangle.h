@@ -27,6 +27,7 @@
 
 #include "yapt.h"
 #include "hittable.h"
+#include "material.h"
 
 class Triangle: public Hittable {
 public:
@@ -34,7 +35,7 @@ public:
     Point3 v[3];
     Vec3 i, j, n;
 
-    Triangle(Point3 a, Vec3 ab, Vec3 ac, shared_ptr<Material> mat): mat(mat), i(ab), j(ac) {
+    Triangle(Point3 a, Vec3 ab, Vec3 ac, shared_ptr<Material> mat): mat(mat), i(ab), j(ac), mat_id(MaterialTable::add(mat)) {
         n = cross(i, j);
         area = n.length();
         n /= area; area /= 2;
@@ -85,20 +86,54 @@ public:
         if (!this->hit(Ray(origin, direction), Interval(0.001, infinity), rec))
             return 0;
 
-        auto distance_squared = rec.t * rec.t * direction.length2();
-        auto cosine = fabs(dot(direction, rec.normal) / direction.length());
+        return sampling_pdf(origin, direction, rec);
+    }
 
-        return distance_squared / (cosine * area);
+    [[nodiscard]] double pdfValue(const Point3 &origin, const Vec3 &direction, const HitRecord &rec) const override {
+        if (light_id < 0)
+            return pdfValue(origin, direction);
+
+        // the hit is already known: no need to intersect again
+        if (rec.light_id != light_id)
+            return 0;
+
+        return sampling_pdf(origin, direction, rec);
     }
 
     [[nodiscard]] Vec3 random(const Point3 &origin) const override {
-        auto r = random_double();
-        auto s = random_double();
-        auto t = random_double();
-        Point3 inside = (r * v[0] + s * v[1] + t * v[2]) / (r + s + t);
+        SphericalTriangle tri;
+        if (sampling == LightSampling::SolidAngle && spherical_triangle(origin, tri)) {
+            const Vec3 direction = tri.sample(random_double(), random_double());
+            // scale the direction so that it reaches the triangle plane
+            const auto denom = dot(n, direction);
+            if (fabs(denom) > EPSILON)
+                return dot(n, v[0] - origin) / denom * direction;
+
+            // grazing the plane: the direction keeps its 1 / solid_angle pdf, the ray misses like any grazing ray
+            return direction;
+        }
+
+        // uniform barycentric coordinates
+        const auto su = sqrt(random_double());
+        const auto b0 = 1 - su;
+        const auto b1 = random_double() * su;
+        Point3 inside = b0 * v[0] + b1 * v[1] + (1 - b0 - b1) * v[2];
         return inside - origin;
     }
 
+    void set_light_sampling(const LightSampling s) override {
+        sampling = s;
+    }
+
+    [[nodiscard]] double power() const override {
+        return mat ? luminance(mat->emission()) * area : 0.0;
+    }
+
+    [[nodiscard]] LightBounds light_bounds() const override {
+        // lights only emit on their front face, in the hemisphere around the normal
+        return {bbox, n, power(), 1, 0, false};
+    }
+
     bool hit(const Ray &r, Interval ray_t, HitRecord &rec) const override {
         Vec3 rayCrossJ = cross(r.direction(), j);
         double det = dot(i, rayCrossJ);
@@ -119,23 +154,116 @@ public:
 
         // the ray and the triangle intersect
 
-        rec.t = invDet * dot(j, sCrossI);
+        const double t = invDet * dot(j, sCrossI);
 
-        if (!(ray_t.contains(rec.t))) return false;
+        if (!(ray_t.contains(t))) return false;
 
-        rec.normal = n;
-
-        rec.mat = mat;
+        rec.t = t;
+        rec.u = u;
+        rec.v = v;
+        rec.mat_id = mat_id;
+        rec.light_id = light_id;
+        rec.deferred = this;
+        return true;
+    }
 
+    void finalize(const Ray &r, HitRecord &rec) const override {
         rec.p = r.at(rec.t);
         rec.set_face_normal(r, n);
-        return true;
     }
 
 private:
     // vertices
+    uint32_t mat_id;
     double area;
     AABB bbox;
+    LightSampling sampling = LightSampling::Area;
+
+    /**
+     * The triangle projected on the unit sphere around an origin, sampled with the method of Arvo, "Stratified
+     * Sampling of Spherical Triangles" (1995)
+     */
+    struct SphericalTriangle {
+        Vec3 a, b, c;     // unit directions to the vertices
+        double alpha;     // spherical angle at a
+        double solid_angle;
+
+        /**
+         * Maps uniform numbers to a direction uniformly distributed in the solid angle of the triangle
+         * @return a unit direction toward the triangle
+         */
+        [[nodiscard]] Vec3 sample(const double s, const double t) const {
+            // choose the sub triangle (a, b, c') of area s * solid_angle
+            const auto area_pi = s * solid_angle + pi;
+            const auto cos_alpha = cos(alpha);
+            const auto sin_alpha = sin(alpha);
+            const auto sin_phi = sin(area_pi) * cos_alpha - cos(area_pi) * sin_alpha;
+            const auto cos_phi = cos(area_pi) * cos_alpha + sin(area_pi) * sin_alpha;
+
+            const auto k1 = cos_phi + cos_alpha;
+            const auto k2 = sin_phi - sin_alpha * dot(a, b);
+            auto cos_bp = (k2 + (k2 * cos_phi - k1 * sin_phi) * cos_alpha) / ((k2 * sin_phi + k1 * cos_phi) * sin_alpha);
+            cos_bp = Interval(-1, 1).clamp(cos_bp);
+            const auto sin_bp = sqrt(fmax(0., 1 - cos_bp * cos_bp));
+            const Vec3 cp = cos_bp * a + sin_bp * unit_vector(c - dot(c, a) * a);
+
+            // then a direction on the arc (b, c')
+            const auto cos_theta = 1 - t * (1 - dot(cp, b));
+            const auto sin_theta = sqrt(fmax(0., 1 - cos_theta * cos_theta));
+            return cos_theta * b + sin_theta * unit_vector(cp - dot(cp, b) * b);
+        }
+    };
+
+    /**
+     * Computes the spherical triangle subtended by the triangle from an origin
+     * @return false if the solid angle is outside of the stable range, in which case area sampling is used
+     */
+    bool spherical_triangle(const Point3 &origin, SphericalTriangle &tri) const {
+        tri.a = unit_vector(v[0] - origin);
+        tri.b = unit_vector(v[1] - origin);
+        tri.c = unit_vector(v[2] - origin);
+
+        Vec3 n_ab = cross(tri.a, tri.b);
+        Vec3 n_bc = cross(tri.b, tri.c);
+        Vec3 n_ca = cross(tri.c, tri.a);
+
+        if (n_ab.length2() == 0 || n_bc.length2() == 0 || n_ca.length2() == 0)
+            return false;
+
+        n_ab = unit_vector(n_ab);
+        n_bc = unit_vector(n_bc);
+        n_ca = unit_vector(n_ca);
+
+        // spherical angles at each vertex, their excess over pi is the solid angle
+        const Interval unit(-1, 1);
+        tri.alpha = acos(unit.clamp(dot(n_ab, -n_ca)));
+        const auto beta = acos(unit.clamp(dot(n_bc, -n_ab)));
+        const auto gamma = acos(unit.clamp(dot(n_ca, -n_bc)));
+        tri.solid_angle = tri.alpha + beta + gamma - pi;
+
+        return tri.solid_angle >= MIN_SOLID_ANGLE_SAMPLING && tri.solid_angle <= MAX_SOLID_ANGLE_SAMPLING;
+    }
+
+    /**
+     * The pdf of sampling a hit point of the triangle with the sampling method of the triangle
+     */
+    [[nodiscard]] double sampling_pdf(const Point3 &origin, const Vec3 &direction, const HitRecord &rec) const {
+        SphericalTriangle tri;
+        if (sampling == LightSampling::SolidAngle && spherical_triangle(origin, tri))
+            return 1 / tri.solid_angle;
+
+        return area_pdf(direction, rec);
+    }
+
+    /**
+     * Converts the uniform area pdf to solid angle at a hit point
+     */
+    [[nodiscard]] double area_pdf(const Vec3 &direction, const HitRecord &rec) const {
+        auto distance_squared = rec.t * rec.t * direction.length2();
+        auto cosine = fabs(dot(direction, n) / direction.length());
+
+        return distance_squared / (cosine * area);
+    }
 };
 
 #endif //YAPT_TRIANGLE_H
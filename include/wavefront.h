@@ -0,0 +1,99 @@
+/*
+ * This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
+ * Copyright (c) 2025 PrISE-3D.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * --- ADDITIONAL PERMISSION UNDER GNU GPL VERSION 3 SECTION 7 ---
+ *
+ * If you modify this Program, or any covered work, by linking or
+ * combining it with the Intel Math Kernel Library (MKL) (or a modified
+ * version of that library), containing parts covered by the terms of
+ * the Intel Simplified Software License, the licensors of this
+ * Program grant you additional permission to convey the resulting work.
+ */
+
+#ifndef YAPT_WAVEFRONT_H
+#define YAPT_WAVEFRONT_H
+
+#include "yapt.h"
+#include "camera.h"
+#include <vector>
+
+/**
+ * Path tracing camera processing paths as streams instead of recursively. Each rendering task keeps the states of
+ * its paths in flight in structure of arrays buffers and runs them through stages, one bounce at a time:
+ * generate -> intersect -> shade (paths grouped by material) -> shadow rays -> accumulate.
+ * Paths are integrated as by ForwardCamera with the NEE (power heuristic MIS) or mixture sampling strategies, and
+ * their contributions are aggregated by the pixel SampleAggregator in sample order.
+ */
+class WavefrontCamera : public ForwardParallelCamera {
+public:
+    std::size_t streamSize = 1 << 16;  // maximum number of paths in flight per task
+
+    void render(const Hittable &world, const Hittable &lights) override;
+    void render_line(const Hittable &world, const Hittable &lights, size_t j) override;
+    std::shared_ptr<SampleAggregator> render_pixel(const Hittable &world, const Hittable &lights, size_t row,
+                                                  size_t column) override;
+
+protected:
+    /**
+     * States of the paths in flight, one entry per path
+     */
+    struct PathStates {
+        std::vector<Ray> rays;            // ray to trace next
+        std::vector<HitRecord> hits;      // closest hit of the ray
+        std::vector<Color> throughputs;   // weight of the light gathered along the ray
+        std::vector<Color> radiances;     // light gathered so far
+        std::vector<double> brdf_pdfs;    // pdf of the BRDF sample that led to the ray, 0 if it needs no MIS weight
+        std::vector<int> depths;          // remaining bounces
+        std::vector<std::size_t> slots;   // index of the sample the path estimates
+
+        void clear();
+        void push(const Ray &ray, std::size_t slot, int depth);
+        [[nodiscard]] std::size_t size() const { return rays.size(); }
+    };
+
+    /**
+     * Shadow rays toward sampled light points, waiting for their visibility test
+     */
+    struct ShadowRays {
+        std::vector<Ray> rays;
+        std::vector<Color> factors;             // throughput times BRDF at the shading point
+        std::vector<double> scattering_pdfs;    // BRDF pdf of the shadow ray direction, for the MIS weight
+        std::vector<std::size_t> paths;
+
+        void clear();
+        [[nodiscard]] std::size_t size() const { return rays.size(); }
+    };
+
+    /**
+     * Renders consecutive pixels of a row through the stream pipeline
+     * @param aggregators filled with one aggregator per pixel, in column order
+     */
+    void render_pixels(const Hittable &world, const Hittable &lights, size_t row, size_t first_column,
+                       size_t end_column, std::vector<std::shared_ptr<SampleAggregator>> &aggregators);
+
+    /**
+     * Traces paths until they all terminate
+     * @param paths the paths to trace, freshly generated
+     * @param results the estimates of the samples, indexed by path slot
+     * @param first_hits the first hits of the samples, indexed by path slot, or empty when no layer needs them
+     */
+    void trace(const Hittable &world, const Hittable &lights, PathStates &paths, std::vector<Color> &results,
+               std::vector<FirstHits> &first_hits) const;
+
+private:
+    bool nee = false;  // set at render time from the sampling strategy
+};
+
+#endif //YAPT_WAVEFRONT_H
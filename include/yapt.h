@@ -36,6 +36,14 @@ using std::make_shared;
 using std::shared_ptr;
 using std::sqrt;
 
+// Precision of the geometry stored by the acceleration structures (YAPT_REAL=float halves their footprint).
+// Intersections, shading and radiance accumulation stay in double.
+#ifndef YAPT_REAL
+#define YAPT_REAL double
+#endif
+
+using real = YAPT_REAL;
+
 // common headers
 #include "utils.h"
 #include "Vec3.h"
@@ -1,81 +0,0 @@
-/*
-* This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
- * Copyright (c) 2025 PrISE-3D.
- * This program is free software: you can redistribute it and/or modify
- * it under the terms of the GNU General Public License as published by
- * the Free Software Foundation, version 3.
- *
- * This program is distributed in the hope that it will be useful, but
- * WITHOUT ANY WARRANTY; without even the implied warranty of
- * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
- * General Public License for more details.
- *
- * You should have received a copy of the GNU General Public License
- * along with this program. If not, see <http://www.gnu.org/licenses/>.
- *
- * --- ADDITIONAL PERMISSION UNDER GNU GPL VERSION 3 SECTION 7 ---
- *
- * If you modify this Program, or any covered work, by linking or
- * combining it with the Intel Math Kernel Library (MKL) (or a modified
- * version of that library), containing parts covered by the terms of
- * the Intel Simplified Software License, the licensors of this
- * Program grant you additional permission to convey the resulting work.
- */
-
-#include <cmath>
-#include "Vec3.h"
-
-using std::sqrt;
-
-Vec3::Vec3() : e{0, 0, 0} {}
-
-Vec3::Vec3(double x, double y, double z) : e{x, y, z} {}
-
-[[nodiscard]] double Vec3::x() const { return e[0]; }
-
-[[nodiscard]] double Vec3::y() const { return e[1]; }
-
-[[nodiscard]] double Vec3::z() const { return e[2]; }
-
-Vec3 Vec3::operator-() const { return {-e[0], -e[1], -e[2]}; }
-
-double Vec3::operator[](int i) const { return e[i]; }
-
-double &Vec3::operator[](int i) { return e[i]; }
-
-Vec3 &Vec3::operator+=(const Vec3 &v) {
-    e[0] += v.e[0];
-    e[1] += v.e[1];
-    e[2] += v.e[2];
-    return *this;
-}
-
-Vec3 &Vec3::operator*=(double t) {
-    e[0] *= t;
-    e[1] *= t;
-    e[2] *= t;
-    return *this;
-}
-
-Vec3 &Vec3::operator/=(double t) {
-    e[0] /= t;
-    e[1] /= t;
-    e[2] /= t;
-    return *this;
-}
-
-[[nodiscard]] double Vec3::length2() const {
-    return e[0] * e[0] + e[1] * e[1] + e[2] * e[2];
-}
-
-[[nodiscard]] double Vec3::length() const {
-    return sqrt(length2());
-}
-
-[[nodiscard]] bool Vec3::near_zero() const {
-    return (fabs(e[0]) < EPSILON) && (fabs(e[1]) < EPSILON) && (fabs(e[2]) < EPSILON);
-}
-
-bool Vec3::operator==(const Vec3& other) const {
-    return are_epsilon_equal(*this, other);
-}
@@ -24,6 +24,7 @@
 
 #include "yapt.h"
 #include "aabb.h"
+#include <limits>
 
 const AABB AABB::empty = AABB(Interval::empty, Interval::empty, Interval::empty);
 const AABB AABB::universe = AABB(Interval::universe, Interval::universe, Interval::universe);
@@ -34,4 +35,58 @@ AABB operator+(const AABB &bbox, const Vec3 &offset) {
 
 AABB operator+(const Vec3 &offset, const AABB &bbox) {
     return bbox + offset;
-}
\ No newline at end of file
+}
+// ============================================================================
+// CompactAABB
+// ============================================================================
+
+namespace {
+    // nearest real not greater than v
+    real round_down(const double v) {
+        const auto r = static_cast<real>(v);
+        return r > v ? std::nextafter(r, -std::numeric_limits<real>::infinity()) : r;
+    }
+
+    // nearest real not lower than v
+    real round_up(const double v) {
+        const auto r = static_cast<real>(v);
+        return r < v ? std::nextafter(r, std::numeric_limits<real>::infinity()) : r;
+    }
+}
+
+CompactAABB::CompactAABB(const AABB &box) {
+    for (int axis = 0; axis < 3; axis++) {
+        const Interval &ax = box.axis_interval(axis);
+        lower[axis] = round_down(ax.min);
+        upper[axis] = round_up(ax.max);
+    }
+}
+
+AABB CompactAABB::to_aabb() const {
+    return {Interval(lower[0], upper[0]), Interval(lower[1], upper[1]), Interval(lower[2], upper[2])};
+}
+
+bool CompactAABB::hit(const Ray &r, Interval ray_t) const {
+    const Point3 &ray_orig = r.origin();
+    const Vec3 &ray_dir = r.direction();
+
+    for (int axis = 0; axis < 3; axis++) {
+        const double adinv = 1.0 / ray_dir[axis];
+
+        // bounds widen exactly to double
+        const auto t0 = (static_cast<double>(lower[axis]) - ray_orig[axis]) * adinv;
+        const auto t1 = (static_cast<double>(upper[axis]) - ray_orig[axis]) * adinv;
+
+        if (t0 < t1) {
+            if (t0 > ray_t.min) ray_t.min = t0;
+            if (t1 < ray_t.max) ray_t.max = t1;
+        } else {
+            if (t1 > ray_t.min) ray_t.min = t1;
+            if (t0 < ray_t.max) ray_t.max = t0;
+        }
+
+        if (ray_t.max <= ray_t.min)
+            return false;
+    }
+    return true;
+}
@@ -69,11 +69,13 @@ void MCSampleAggregator::sample_from(const std::shared_ptr<SamplerFactory> f, co
 // ============================================================================
 
 Color MedianAggregator::aggregate() {
-    std::sort(contributions.begin(), contributions.end(), [](const Color & a, const Color & b) {
+    // sorted apart: contributions stay paired with their samples for the dumps, layers and inspectors
+    std::pmr::vector<Color> sorted(contributions.begin(), contributions.end(), PixelArena::resource());
+    const auto mid = sorted.begin() + static_cast<long>(sorted.size() / 2);
+    std::nth_element(sorted.begin(), mid, sorted.end(), [](const Color & a, const Color & b) {
         return luminance(a) < luminance(b);
     });
-    const int mid = contributions.size() / 2;
-    return contributions[mid];
+    return *mid;
 }
 
 // ============================================================================
@@ -114,7 +116,9 @@ WinsorAggregator::WinsorAggregator(double rejectRate, bool clipped)
     : MCSampleAggregator(), rejectRate(rejectRate), clipped(clipped) {}
 
 Color WinsorAggregator::aggregate() {
-    std::sort(contributions.begin(), contributions.end(), [](const Color & a, const Color & b) {
+    // sorted apart, as by the median
+    std::pmr::vector<Color> sorted(contributions.begin(), contributions.end(), PixelArena::resource());
+    std::sort(sorted.begin(), sorted.end(), [](const Color & a, const Color & b) {
         return luminance(a) < luminance(b);
     });
 
@@ -127,10 +131,10 @@ Color WinsorAggregator::aggregate() {
 
     if (!clipped) {
         for (size_t i = 0 ; i < min - 1 ; ++i) {
-            sum += contributions[min];
+            sum += sorted[min];
         }
         for (size_t i = max + 1 ; i < _usable_sample_count ; ++i) {
-            sum += contributions[max];
+            sum += sorted[max];
         }
         corrected_size = _usable_sample_count;
     } else {
@@ -138,7 +142,7 @@ Color WinsorAggregator::aggregate() {
     }
 
     for (size_t i = min; i < max; ++i) {
-        sum += contributions[i];
+        sum += sorted[i];
     }
 
     return sum / corrected_size;
@@ -167,7 +171,6 @@ void VoronoiAggregator::sample_from(std::shared_ptr<SamplerFactory> factory, dou
     do {
         isInvalid = false;
         // we collect samples
-        const auto pixelSampler = factory->create(x, y);
         SampleAggregator::sample_from(factory, x, y);
         contributions.clear();
         contributions.reserve(_usable_sample_count);
@@ -194,7 +197,7 @@ void VoronoiAggregator::sample_from(std::shared_ptr<SamplerFactory> factory, dou
 }
 
 Color VoronoiAggregator::aggregate() {
-    weights = std::vector<double>(_usable_sample_count);
+    weights.assign(_usable_sample_count, 0.);
     double total_weight = 0.;
     int idx = 0;
 
@@ -237,7 +240,7 @@ FilteringVoronoiAggregator::FilteringVoronoiAggregator(const double margin)
     : VoronoiAggregator(), margin(margin) {}
 
 Color FilteringVoronoiAggregator::aggregate() {
-    weights = std::vector<double>(_usable_sample_count);
+    weights.assign(_usable_sample_count, 0.);
     double total_weight = 0.;
     int idx = 0;
 
@@ -336,7 +339,6 @@ void NicoVoronoiAggregator::sample_from(std::shared_ptr<SamplerFactory> factory,
     do {
         isInvalid = false;
         // we collect samples
-        const auto pixelSampler = factory->create(x, y);
         SampleAggregator::sample_from(factory, x, y);
         contributions.clear();
         contributions.reserve(_usable_sample_count);
@@ -386,33 +388,33 @@ void NicoVoronoiAggregator::sample_from(std::shared_ptr<SamplerFactory> factory,
 // ============================================================================
 
 std::shared_ptr<SampleAggregator> MCAggregatorFactory::create() {
-    return std::make_shared<MCSampleAggregator>();
+    return make_pixel_shared<MCSampleAggregator>();
 }
 
 std::shared_ptr<SampleAggregator> VoronoiAggregatorFactory::create() {
-    return std::make_shared<VoronoiAggregator>();
+    return make_pixel_shared<VoronoiAggregator>();
 }
 
 shared_ptr<SampleAggregator> ClippedVoronoiAggregatorFactory::create() {
-    return std::make_shared<ClippedVoronoiAggregator>();
+    return make_pixel_shared<ClippedVoronoiAggregator>();
 }
 
 shared_ptr<SampleAggregator> MedianAggregatorFactory::create() {
-    return std::make_shared<MedianAggregator>();
+    return make_pixel_shared<MedianAggregator>();
 }
 
 MonAggregatorFactory::MonAggregatorFactory(size_t nb_blocks)
     : AggregatorFactory(), nb_blocks(nb_blocks) {}
 
 shared_ptr<SampleAggregator> MonAggregatorFactory::create() {
-    return std::make_shared<MonAggregator>(nb_blocks);
+    return make_pixel_shared<MonAggregator>(nb_blocks);
 }
 
 WinsorAggregatorFactory::WinsorAggregatorFactory(double rejectRate, bool clipped)
     : AggregatorFactory(), rejectRate(rejectRate), clipped(clipped) {}
 
 shared_ptr<SampleAggregator> WinsorAggregatorFactory::create() {
-    return std::make_shared<WinsorAggregator>(rejectRate, clipped);
+    return make_pixel_shared<WinsorAggregator>(rejectRate, clipped);
 }
 
 FilteringVoronoiAggregatorFactory::FilteringVoronoiAggregatorFactory(): AggregatorFactory(), margin(.1) {}
@@ -421,7 +423,7 @@ FilteringVoronoiAggregatorFactory::FilteringVoronoiAggregatorFactory(const doubl
     : AggregatorFactory(), margin(m) {}
 
 shared_ptr<SampleAggregator> FilteringVoronoiAggregatorFactory::create() {
-    return std::make_shared<FilteringVoronoiAggregator>(margin);
+    return make_pixel_shared<FilteringVoronoiAggregator>(margin);
 }
 
 NicoVoronoiAggregatorFactory::NicoVoronoiAggregatorFactory() : AggregatorFactory(), margin(.1) {}
@@ -429,5 +431,5 @@ NicoVoronoiAggregatorFactory::NicoVoronoiAggregatorFactory() : AggregatorFactory
 NicoVoronoiAggregatorFactory::NicoVoronoiAggregatorFactory(double m) : AggregatorFactory(), margin(m) {}
 
 shared_ptr<SampleAggregator> NicoVoronoiAggregatorFactory::create() {
-    return std::make_shared<NicoVoronoiAggregator>(margin);
+    return make_pixel_shared<NicoVoronoiAggregator>(margin);
 }
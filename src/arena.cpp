@@ -0,0 +1,62 @@
+/*
+ * This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
+ * Copyright (c) 2025 PrISE-3D.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * --- ADDITIONAL PERMISSION UNDER GNU GPL VERSION 3 SECTION 7 ---
+ *
+ * If you modify this Program, or any covered work, by linking or
+ * combining it with the Intel Math Kernel Library (MKL) (or a modified
+ * version of that library), containing parts covered by the terms of
+ * the Intel Simplified Software License, the licensors of this
+ * Program grant you additional permission to convey the resulting work.
+ */
+
+#include "arena.h"
+
+namespace {
+    constexpr std::size_t initial_arena_size = 64 * 1024;
+    constexpr std::size_t largest_pooled_block = 16 * 1024 * 1024;
+
+    // the arena bumps into blocks recycled by the pool, so that steady state pixels do not reach the heap
+    struct ThreadArena {
+        std::pmr::unsynchronized_pool_resource pool{std::pmr::pool_options{0, largest_pooled_block}};
+        std::pmr::monotonic_buffer_resource arena{initial_arena_size, &pool};
+        bool active = false;
+    };
+
+    ThreadArena &thread_arena() {
+        thread_local ThreadArena instance;
+        return instance;
+    }
+}
+
+std::pmr::memory_resource *PixelArena::resource() {
+    ThreadArena &local = thread_arena();
+    return local.active ? &local.arena : std::pmr::get_default_resource();
+}
+
+PixelArena::Scope::Scope() {
+    ThreadArena &local = thread_arena();
+    nested = local.active;
+    local.active = true;
+}
+
+PixelArena::Scope::~Scope() {
+    if (nested)
+        return;
+
+    ThreadArena &local = thread_arena();
+    local.active = false;
+    local.arena.release();
+}
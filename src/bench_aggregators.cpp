@@ -0,0 +1,111 @@
+/*
+ * This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
+ * Copyright (c) 2025 PrISE-3D.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * --- ADDITIONAL PERMISSION UNDER GNU GPL VERSION 3 SECTION 7 ---
+ *
+ * If you modify this Program, or any covered work, by linking or
+ * combining it with the Intel Math Kernel Library (MKL) (or a modified
+ * version of that library), containing parts covered by the terms of
+ * the Intel Simplified Software License, the licensors of this
+ * Program grant you additional permission to convey the resulting work.
+ */
+
+#include "parser.h"
+#include <chrono>
+#include <sstream>
+
+namespace {
+    std::vector<std::string> split(const std::string &list) {
+        std::vector<std::string> items;
+        std::stringstream stream(list);
+        std::string item;
+        while (std::getline(stream, item, ','))
+            if (!item.empty()) items.push_back(item);
+        return items;
+    }
+}
+
+/**
+ * Measures the pixels per second of aggregation methods on the first lines of a scene: the pixels of a line are
+ * gathered, then prepared together and aggregated, as the cameras do. Gathering and aggregation are timed apart.
+ * usage: bench_aggregators source=../scenes/cornell.ypt aggregators=vor,torch torchmodel=weights.pt lines=4
+ */
+int main(int argc, char *argv[]) {
+    const std::string aggregatorsprefix = "aggregators=";
+    const std::string linesprefix = "lines=";
+    const std::string torchmodelprefix = "torchmodel=";
+    std::vector<std::string> aggregators = {"vor", "torch"};
+    std::size_t lines = 4;
+    std::filesystem::path model;
+
+    for (int i = 1; i < argc; i++) {
+        std::string parameter(argv[i]);
+        if (parameter.rfind(aggregatorsprefix, 0) == 0)
+            aggregators = split(parameter.substr(aggregatorsprefix.size()));
+        else if (parameter.rfind(linesprefix, 0) == 0)
+            lines = std::stoul(parameter.substr(linesprefix.size()));
+        else if (parameter.rfind(torchmodelprefix, 0) == 0)
+            model = parameter.substr(torchmodelprefix.size());
+    }
+
+    Parser parser;
+    Scene scene;
+
+    // load the scene description and camera
+    if (!parser.parseScene(argc, argv, scene)) return 0;
+
+    const auto &camera = scene.camera;
+    camera->initialize();
+    lines = std::min(lines, camera->imageHeight);
+
+    for (const auto &aggregator : aggregators) {
+        const auto aggregatorFactory = Parser::createAggregatorFactory(aggregator, parser.getSamplerFactory(), 5, .05,
+                                                                       false, model);
+        if (!aggregatorFactory) {
+            std::cerr << "Cannot create the aggregator: " << aggregator << std::endl;
+            continue;
+        }
+        camera->samplerAggregator = aggregatorFactory;
+
+        std::chrono::duration<double> gathering(0);
+        std::chrono::duration<double> aggregation(0);
+        double checksum = 0.;
+
+        for (std::size_t row = 0; row < lines; ++row) {
+            PixelArena::Scope scope;
+            std::vector<std::shared_ptr<SampleAggregator>> line;
+            line.reserve(camera->imageWidth);
+
+            const auto start = std::chrono::steady_clock::now();
+            for (std::size_t column = 0; column < camera->imageWidth; ++column)
+                line.push_back(camera->sample_pixel(*scene.content, *scene.lightSampler, row, column,
+                                                    static_cast<uint32_t>(camera->seed)));
+            const auto gathered = std::chrono::steady_clock::now();
+
+            aggregatorFactory->prepare(line);
+            for (const auto &pixel : line)
+                checksum += luminance(pixel->aggregate());
+            const auto aggregated = std::chrono::steady_clock::now();
+
+            gathering += gathered - start;
+            aggregation += aggregated - gathered;
+        }
+
+        const auto pixels = static_cast<double>(lines * camera->imageWidth);
+        std::cout << aggregator << " : " << pixels / aggregation.count() << " pixels/s aggregated, "
+                  << pixels / (gathering + aggregation).count() << " pixels/s overall (mean luminance "
+                  << checksum / pixels << ")" << std::endl;
+    }
+}
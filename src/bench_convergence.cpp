@@ -0,0 +1,352 @@
+/*
+ * This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
+ * Copyright (c) 2025 PrISE-3D.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * --- ADDITIONAL PERMISSION UNDER GNU GPL VERSION 3 SECTION 7 ---
+ *
+ * If you modify this Program, or any covered work, by linking or
+ * combining it with the Intel Math Kernel Library (MKL) (or a modified
+ * version of that library), containing parts covered by the terms of
+ * the Intel Simplified Software License, the licensors of this
+ * Program grant you additional permission to convey the resulting work.
+ */
+
+#include "parser.h"
+#include "arena.h"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <thread>
+
+#ifdef FUNCTION_PARSING
+
+namespace {
+    struct Options {
+        std::filesystem::path functions = "../functions";
+        std::vector<std::string> samplers = {"rnd", "strat", "sppp"};
+        std::vector<std::string> aggregators = {"mc", "vor"};
+        std::vector<std::size_t> ladder = {16, 64, 256, 1024};
+        std::size_t seeds = 32;
+        std::size_t threads = 0;
+        std::size_t reference = 4096;
+        std::filesystem::path cache = std::filesystem::temp_directory_path() / "yapt-references";
+        std::string format = "csv";
+        std::filesystem::path out;
+        double confidence = .999;
+        bool jit = false;
+    };
+
+    struct Result {
+        std::string function;
+        std::string sampler;
+        std::string aggregator;
+        std::size_t spp;
+        std::size_t seeds;
+        double reference;
+        double mean;
+        double bias;
+        double variance;
+        double rmse;
+        double time;  // mean wall time of a run, in ms
+    };
+
+    std::vector<std::string> split(const std::string &list) {
+        std::vector<std::string> items;
+        std::stringstream stream(list);
+        std::string item;
+        while (std::getline(stream, item, ','))
+            if (!item.empty()) items.push_back(item);
+        return items;
+    }
+
+    /**
+     * Integral of a function over the pixel [-.5, .5]², by jittered stratified sampling on a side x side grid.
+     * Values are cached on disk, keyed by the expression and the grid size.
+     */
+    double reference_integral(const std::filesystem::path &file, const Function &function, const std::size_t side,
+                              const std::filesystem::path &cache) {
+        std::ifstream input(file);
+        std::string expression;
+        std::getline(input, expression);
+
+        const std::size_t key = std::hash<std::string>()(expression + "@" + std::to_string(side));
+        const auto cached = cache / (file.stem().string() + "-" + std::to_string(key) + ".ref");
+
+        if (std::ifstream stored(cached); stored) {
+            double value;
+            if (stored >> value) return value;
+        }
+
+        random_seed(0);
+        const double step = 1. / static_cast<double>(side);
+        std::vector<double> x(side), y(side), values(side);
+        double sum = 0.;
+
+        for (std::size_t j = 0; j < side; ++j) {
+            for (std::size_t i = 0; i < side; ++i) {
+                x[i] = -.5 + (i + random_double()) * step;
+                y[i] = -.5 + (j + random_double()) * step;
+            }
+            function.compute_batch(x.data(), y.data(), values.data(), side);
+
+            double row = 0.;
+            for (const double v : values) row += v;
+            sum += row;
+        }
+
+        const double value = sum / static_cast<double>(side * side);
+
+        std::error_code error;
+        std::filesystem::create_directories(cache, error);
+        std::ofstream stored(cached);
+        stored.precision(17);
+        stored << value << std::endl;
+
+        return value;
+    }
+
+    // estimates of the integral for seeds 0..n-1, and the mean wall time of a run
+    std::vector<double> estimate(const Function &function, const shared_ptr<SamplerFactory> &samplerFactory,
+                                 const shared_ptr<AggregatorFactory> &aggregatorFactory, const std::size_t seeds,
+                                 const std::size_t threads, double &time) {
+        std::vector<double> estimates(seeds);
+        std::vector<double> times(seeds);
+        std::atomic<std::size_t> next{0};
+
+        auto worker = [&]() {
+            for (std::size_t seed = next++; seed < seeds; seed = next++) {
+                const auto start = std::chrono::steady_clock::now();
+                PixelArena::Scope scope;
+                random_seed(combine(static_cast<uint32_t>(seed), 0, 0));
+
+                const auto aggregator = aggregatorFactory->create();
+                aggregator->sample_from(samplerFactory, 0., 0.);
+
+                const auto count = static_cast<std::size_t>(aggregator->end() - aggregator->begin());
+                std::pmr::vector<double> xs(count, PixelArena::resource());
+                std::pmr::vector<double> ys(count, PixelArena::resource());
+                std::pmr::vector<double> values(count, PixelArena::resource());
+
+                std::size_t i = 0;
+                for (const Sample &sample : *aggregator) {
+                    xs[i] = sample.dx;
+                    ys[i] = sample.dy;
+                    ++i;
+                }
+
+                function.compute_batch(xs.data(), ys.data(), values.data(), count);
+                for (const double value : values)
+                    aggregator->insert_contribution(Color(value, value, value));
+
+                estimates[seed] = aggregator->aggregate().x();
+
+                const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+                times[seed] = elapsed.count();
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for (std::size_t t = 0; t < threads; ++t)
+            pool.emplace_back(worker);
+        for (auto &thread : pool)
+            thread.join();
+
+        time = 0.;
+        for (const double t : times) time += t;
+        time /= static_cast<double>(seeds);
+
+        return estimates;
+    }
+
+    void write_csv(std::ostream &out, const std::vector<Result> &results) {
+        out << "function,sampler,aggregator,spp,seeds,reference,mean,bias,variance,rmse,time_ms" << std::endl;
+        for (const auto &r : results) {
+            out << r.function << ',' << r.sampler << ',' << r.aggregator << ',' << r.spp << ',' << r.seeds << ','
+                << r.reference << ',' << r.mean << ',' << r.bias << ',' << r.variance << ',' << r.rmse << ','
+                << r.time << std::endl;
+        }
+    }
+
+    void write_json(std::ostream &out, const std::vector<Result> &results) {
+        out << "[" << std::endl;
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            const auto &r = results[i];
+            out << "  {\"function\": \"" << r.function << "\", \"sampler\": \"" << r.sampler
+                << "\", \"aggregator\": \"" << r.aggregator << "\", \"spp\": " << r.spp << ", \"seeds\": " << r.seeds
+                << ", \"reference\": " << r.reference << ", \"mean\": " << r.mean << ", \"bias\": " << r.bias
+                << ", \"variance\": " << r.variance << ", \"rmse\": " << r.rmse << ", \"time_ms\": " << r.time << "}"
+                << (i + 1 < results.size() ? "," : "") << std::endl;
+        }
+        out << "]" << std::endl;
+    }
+
+    bool parse(const int argc, char *argv[], Options &options) {
+        const std::string functionsprefix = "functions=";
+        const std::string samplersprefix = "samplers=";
+        const std::string aggregatorsprefix = "aggregators=";
+        const std::string sppprefix = "spp=";
+        const std::string seedsprefix = "seeds=";
+        const std::string threadsprefix = "threads=";
+        const std::string referenceprefix = "reference=";
+        const std::string cacheprefix = "cache=";
+        const std::string formatprefix = "format=";
+        const std::string outprefix = "out=";
+        const std::string confidenceprefix = "confidence=";
+        const std::string jitprefix = "jit=";
+
+        for (int i = 1; i < argc; i++) {
+            std::string parameter(argv[i]);
+            if (parameter.rfind(functionsprefix, 0) == 0) {
+                options.functions = parameter.substr(functionsprefix.size());
+            } else if (parameter.rfind(samplersprefix, 0) == 0) {
+                options.samplers = split(parameter.substr(samplersprefix.size()));
+            } else if (parameter.rfind(aggregatorsprefix, 0) == 0) {
+                options.aggregators = split(parameter.substr(aggregatorsprefix.size()));
+            } else if (parameter.rfind(sppprefix, 0) == 0) {
+                options.ladder.clear();
+                for (const auto &spp : split(parameter.substr(sppprefix.size())))
+                    options.ladder.push_back(std::stoul(spp));
+            } else if (parameter.rfind(seedsprefix, 0) == 0) {
+                options.seeds = std::stoul(parameter.substr(seedsprefix.size()));
+            } else if (parameter.rfind(threadsprefix, 0) == 0) {
+                options.threads = std::stoul(parameter.substr(threadsprefix.size()));
+            } else if (parameter.rfind(referenceprefix, 0) == 0) {
+                options.reference = std::stoul(parameter.substr(referenceprefix.size()));
+            } else if (parameter.rfind(cacheprefix, 0) == 0) {
+                options.cache = parameter.substr(cacheprefix.size());
+            } else if (parameter.rfind(formatprefix, 0) == 0) {
+                options.format = parameter.substr(formatprefix.size());
+            } else if (parameter.rfind(outprefix, 0) == 0) {
+                options.out = parameter.substr(outprefix.size());
+            } else if (parameter.rfind(confidenceprefix, 0) == 0) {
+                options.confidence = std::stod(parameter.substr(confidenceprefix.size()));
+            } else if (parameter.rfind(jitprefix, 0) == 0) {
+                options.jit = parameter.substr(jitprefix.size()) == "true";
+            } else if (parameter.rfind("help", 0) == 0) {
+                std::cout << "usage: bench_convergence functions=../functions samplers=rnd,sppp aggregators=mc,vor spp=16,64,256" << std::endl;
+                std::cout << " - functions   => .func file or directory of .func files (DEFAULT=../functions)" << std::endl;
+                std::cout << " - samplers    => comma separated pixel sampling methods (DEFAULT=rnd,strat,sppp)" << std::endl;
+                std::cout << " - aggregators => comma separated aggregation methods (DEFAULT=mc,vor)" << std::endl;
+                std::cout << " - spp         => comma separated samples per pixel ladder (DEFAULT=16,64,256,1024)" << std::endl;
+                std::cout << " - seeds       => runs per configuration, at least 2 (DEFAULT=32)" << std::endl;
+                std::cout << " - threads     => number of threads used (DEFAULT=hardware_concurrency)" << std::endl;
+                std::cout << " - reference   => side of the stratified grid of the reference integrals (DEFAULT=4096)" << std::endl;
+                std::cout << " - cache       => directory of the cached reference integrals (DEFAULT=temporary directory)" << std::endl;
+                std::cout << " - format      => csv or json (DEFAULT=csv)" << std::endl;
+                std::cout << " - out         => output file (DEFAULT=standard output)" << std::endl;
+                std::cout << " - confidence  => Voronoi aggregation confidence (DEFAULT=.999)" << std::endl;
+                std::cout << " - jit         => compiles the functions to native code (DEFAULT = false)" << std::endl;
+                return false;
+            }
+        }
+
+        if (options.threads == 0) options.threads = std::max(1u, std::thread::hardware_concurrency());
+        return true;
+    }
+}
+
+/**
+ * Convergence benchmark of the samplers and aggregators on the .func integrands: for each function, sampler,
+ * aggregator and spp, estimates the integral over a pixel with several seeds, and reports bias, variance and RMSE
+ * against a reference integral, with the mean time of a run.
+ */
+int main(int argc, char *argv[]) {
+    Options options;
+    if (!parse(argc, argv, options)) return 0;
+
+    // the mean time divides by the number of runs and the variance by one less
+    if (options.seeds < 2) {
+        std::cerr << "At least 2 seeds are needed to estimate a variance, got seeds=" << options.seeds << std::endl;
+        return 1;
+    }
+
+    std::vector<std::filesystem::path> files;
+    if (std::filesystem::is_directory(options.functions)) {
+        for (const auto &entry : std::filesystem::directory_iterator(options.functions))
+            if (entry.path().extension() == ".func") files.push_back(entry.path());
+        std::sort(files.begin(), files.end());
+    } else {
+        files.push_back(options.functions);
+    }
+
+    std::vector<Result> results;
+
+    for (const auto &file : files) {
+        const auto function = Function::from_file(file.string(), options.jit);
+        if (!function) continue;
+
+        const double reference = reference_integral(file, *function, options.reference, options.cache);
+        std::cerr << file.stem().string() << ": reference " << reference << std::endl;
+
+        for (const auto &sampler : options.samplers) {
+            for (const auto &aggregator : options.aggregators) {
+                for (std::size_t spp : options.ladder) {
+                    const auto samplerFactory = Parser::createSamplerFactory(sampler, spp, options.confidence);
+                    if (!samplerFactory) {
+                        std::cerr << "Unknown sampler: " << sampler << std::endl;
+                        return 1;
+                    }
+
+                    const auto aggregatorFactory = Parser::createAggregatorFactory(aggregator, samplerFactory, 5, .05, false);
+                    if (!aggregatorFactory) {
+                        std::cerr << "Unknown aggregator: " << aggregator << std::endl;
+                        return 1;
+                    }
+
+                    double time;
+                    const auto estimates = estimate(*function, samplerFactory, aggregatorFactory, options.seeds,
+                                                    options.threads, time);
+
+                    double mean = 0., squared_error = 0.;
+                    for (const double e : estimates) {
+                        mean += e;
+                        squared_error += (e - reference) * (e - reference);
+                    }
+                    mean /= static_cast<double>(estimates.size());
+
+                    double variance = 0.;
+                    for (const double e : estimates) variance += (e - mean) * (e - mean);
+                    variance /= static_cast<double>(std::max<std::size_t>(estimates.size() - 1, 1));
+
+                    results.push_back({file.stem().string(), sampler, aggregator, spp, options.seeds, reference, mean,
+                                       mean - reference, variance,
+                                       std::sqrt(squared_error / static_cast<double>(estimates.size())), time});
+                }
+            }
+        }
+    }
+
+    std::ofstream file;
+    if (!options.out.empty()) file.open(options.out);
+    std::ostream &out = options.out.empty() ? std::cout : file;
+    out.precision(10);
+
+    if (options.format == "json")
+        write_json(out, results);
+    else
+        write_csv(out, results);
+
+    return 0;
+}
+
+#else
+
+int main() {
+    std::cerr << "bench_convergence requires FUNCTION_PARSING" << std::endl;
+    return 1;
+}
+
+#endif
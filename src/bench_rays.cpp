@@ -0,0 +1,131 @@
+/*
+ * This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
+ * Copyright (c) 2025 PrISE-3D.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * --- ADDITIONAL PERMISSION UNDER GNU GPL VERSION 3 SECTION 7 ---
+ *
+ * If you modify this Program, or any covered work, by linking or
+ * combining it with the Intel Math Kernel Library (MKL) (or a modified
+ * version of that library), containing parts covered by the terms of
+ * the Intel Simplified Software License, the licensors of this
+ * Program grant you additional permission to convey the resulting work.
+ */
+
+#include "parser.h"
+#include <bitset>
+#include <chrono>
+
+namespace {
+    // traces the rays, returns the number of closest hit queries per second
+    double trace(const Hittable &world, const std::vector<Ray> &rays, std::size_t &hits) {
+        const auto start = std::chrono::steady_clock::now();
+
+        hits = 0;
+        for (const Ray &r: rays) {
+            HitRecord rec;
+            if (world.hit(r, Interval(0.001, infinity), rec))
+                ++hits;
+        }
+
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return static_cast<double>(rays.size()) / elapsed.count();
+    }
+
+    // traces the rays by packets of consecutive rays, returns the number of closest hit queries per second
+    double trace_packets(const Hittable &world, const std::vector<Ray> &rays, const std::size_t size,
+                         std::size_t &hits) {
+        const auto start = std::chrono::steady_clock::now();
+
+        hits = 0;
+        RayPacket packet;
+        for (std::size_t first = 0; first < rays.size(); first += size) {
+            packet.clear();
+            for (std::size_t i = first; i < std::min(first + size, rays.size()); ++i)
+                packet.add(rays[i]);
+            packet.prepare();
+
+            hits += std::bitset<RayPacket::capacity>(world.hit_packet(packet, Interval(0.001, infinity))).count();
+        }
+
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return static_cast<double>(rays.size()) / elapsed.count();
+    }
+}
+
+/**
+ * Measures the closest hit queries per second on a scene, for coherent rays shot from the camera and incoherent
+ * rays shot in random directions from random points of the scene. With packet=N (2 to 16), the coherent rays are shot by
+ * groups of N through the footprint of a pixel, and are also traced as packets to report the speedup over single rays
+ * usage: bench_rays source=../scenes/cornell.ypt rays=1000000 packet=16
+ */
+int main(int argc, char *argv[]) {
+    const std::string raysprefix = "rays=";
+    const std::string packetprefix = "packet=";
+    std::size_t count = 1000000;
+    std::size_t packetSize = 1;
+
+    for (int i = 1; i < argc; i++) {
+        std::string parameter(argv[i]);
+        if (parameter.rfind(raysprefix, 0) == 0)
+            count = std::stoul(parameter.substr(raysprefix.size()));
+        else if (parameter.rfind(packetprefix, 0) == 0)
+            packetSize = std::clamp<std::size_t>(std::stoul(parameter.substr(packetprefix.size())), 1,
+                                                 RayPacket::capacity);
+    }
+
+    Parser parser;
+    Scene scene;
+
+    // load the scene description and camera
+    if (!parser.parseScene(argc, argv, scene)) return 0;
+
+    const AABB box = scene.content->bounding_box();
+    const auto random_point = [&box]() {
+        return Point3(random_double(box.x.min, box.x.max),
+                      random_double(box.y.min, box.y.max),
+                      random_double(box.z.min, box.z.max));
+    };
+
+    random_seed(1);
+
+    // each group of packetSize rays aims at a pixel sized neighbourhood of a random point
+    const double pixel_angle = degrees_to_radians(scene.camera->vfov) * scene.camera->aspect_ratio /
+                               static_cast<double>(scene.camera->imageWidth);
+    std::vector<Ray> primary(count);
+    for (std::size_t first = 0; first < count; first += packetSize) {
+        const Vec3 target = random_point() - scene.camera->lookFrom;
+        const double footprint = target.length() * pixel_angle;
+        for (std::size_t i = first; i < std::min(first + packetSize, count); ++i)
+            primary[i] = Ray(scene.camera->lookFrom, target + footprint / 2 * random_in_unit_sphere());
+    }
+
+    std::vector<Ray> incoherent(count);
+    for (auto &r: incoherent)
+        r = Ray(random_point(), random_unit_vector());
+
+    std::size_t hits;
+    trace(*scene.content, primary, hits);  // warm up
+
+    const double primary_rate = trace(*scene.content, primary, hits);
+    std::cout << "primary    : " << primary_rate / 1e6 << " Mrays/s (" << hits << " hits)" << std::endl;
+
+    const double incoherent_rate = trace(*scene.content, incoherent, hits);
+    std::cout << "incoherent : " << incoherent_rate / 1e6 << " Mrays/s (" << hits << " hits)" << std::endl;
+
+    if (packetSize > 1) {
+        const double packet_rate = trace_packets(*scene.content, primary, packetSize, hits);
+        std::cout << "packets    : " << packet_rate / 1e6 << " Mrays/s (" << hits << " hits), x"
+                  << packet_rate / primary_rate << " over single primary rays" << std::endl;
+    }
+}
@@ -25,6 +25,8 @@
 #include "yapt.h"
 #include "camera.h"
 #include "material.h"
+#include "ray_packet.h"
+#include "arena.h"
 #include <thread>
 #include <mutex>
 #include <vector>
@@ -32,6 +34,17 @@
 #include <condition_variable>
 #include <memory>
 
+namespace {
+    /**
+     * Lines rendered by a thread when the image is streamed to a TileSink
+     */
+    struct Band {
+        size_t first_row;
+        std::vector<float> data;
+    };
+
+    thread_local Band *currentBand = nullptr;
+}
 
 void Camera::initialize() {
     imageHeight = static_cast<size_t>(static_cast<double>(imageWidth) / aspect_ratio);
@@ -66,9 +79,16 @@ void Camera::initialize() {
     defocusDiskU = u * defocusRadius;
     defocusDiskV = v * defocusRadius;
 
-    imageData.data = std::vector<double>(imageWidth * imageHeight * 3);
-    imageData.width = imageWidth;
-    imageData.height = imageHeight;
+    imageData->width = imageWidth;
+    imageData->height = imageHeight;
+    imageData->layers.clear();
+
+    // a streamed image only exists as the bands being rendered
+    imageData->data = std::vector<float>(tileSink ? 0 : imageWidth * imageHeight * 3);
+    if (tileSink) return;
+
+    for (const auto &aov : aovs)
+        imageData->add_layer(aov, aov == "depth" || aov == "count" ? 1 : 3);
 }
 
 /**
@@ -100,42 +120,184 @@ Point3 Camera::defocusDiskSample() const {
 
 
 void ForwardCamera::render_line(const Hittable &world, const Hittable &lights, size_t j) {
+    if (samplerAggregator->batched()) {
+        // the line is gathered before its pixels are prepared together, the aggregators go before the arena
+        PixelArena::Scope scope;
+        std::vector<std::shared_ptr<SampleAggregator>> aggregators;
+        aggregators.reserve(imageWidth);
+
+        for (size_t column = 0; column < imageWidth; ++column)
+            aggregators.push_back(sample_pixel(world, lights, j, column, static_cast<uint32_t>(seed)));
+
+        samplerAggregator->prepare(aggregators);
+
+        for (size_t column = 0; column < imageWidth; ++column)
+            persist_pixel(j, column, *aggregators[column]);
+        return;
+    }
+
     for (size_t column = 0; column < imageWidth; ++column) {
+        // the aggregator is dropped with the pixel: its data is released with the arena
+        PixelArena::Scope scope;
         render_pixel(world, lights, j, column);
     }
 }
 
-inline uint64_t combine(const uint32_t seed, const uint32_t x, const uint32_t y) {
-    auto combined = static_cast<uint64_t>(seed);
-    combined = (combined << 32) | ((static_cast<uint64_t>(x & 0xFFFF) << 16) | (y & 0xFFFF));
-    return combined;
+void ForwardCamera::persist_color_to_data(const size_t row, const size_t column, const Color pixel_color) {
+    float *pixels = imageData->data.data();
+    size_t line = row;
+
+    if (currentBand) {
+        pixels = currentBand->data.data();
+        line = row - currentBand->first_row;
+    }
+
+    const size_t idx = 3 * (column + line * imageWidth);
+
+    pixels[idx]     = static_cast<float>(pixel_color.x());  // R
+    pixels[idx + 1] = static_cast<float>(pixel_color.y());  // G
+    pixels[idx + 2] = static_cast<float>(pixel_color.z());  // B
 }
 
-void ForwardCamera::persist_color_to_data(const size_t row, const size_t column, const Color pixel_color) {
-    const size_t idx = 3 * (column + row * imageWidth);
+void ForwardCamera::persist_aovs(const size_t row, const size_t column, const SampleAggregator &aggregator) {
+    const auto count = static_cast<size_t>(aggregator.end() - aggregator.begin());
+    const double n = static_cast<double>(std::max<size_t>(count, 1));
+    const size_t pixel = column + row * imageWidth;
+    const FirstHits &hits = aggregator.firstHits;
+
+    Color mean(0, 0, 0);
+    for (const Color &c : aggregator.contributions) mean += c;
+    mean /= n;
+
+    Color variance(0, 0, 0);
+    for (const Color &c : aggregator.contributions) variance += (c - mean) * (c - mean);
+    if (count > 1) variance /= n * (n - 1);
+
+    for (auto &layer : imageData->layers) {
+        float *values = layer.data.data() + layer.channels * pixel;
+        Color value;
+
+        if (layer.name == "albedo") value = hits.albedo / n;
+        else if (layer.name == "normal") value = hits.normal / n;
+        else if (layer.name == "depth") value = Color(hits.depth / n, 0, 0);
+        else if (layer.name == "variance") value = variance;
+        else if (layer.name == "count") value = Color(static_cast<double>(count), 0, 0);
+        else if (layer.name == "mc") value = mean;
+        else continue;
+
+        for (size_t c = 0; c < layer.channels; ++c)
+            values[c] = static_cast<float>(value[static_cast<int>(c)]);
+    }
+}
 
-    imageData.data[idx]     = pixel_color.x();  // R
-    imageData.data[idx + 1] = pixel_color.y();  // G
-    imageData.data[idx + 2] = pixel_color.z();  // B
+bool ForwardCamera::records_first_hits() const {
+    return std::any_of(imageData->layers.begin(), imageData->layers.end(), [](const auto &layer) {
+        return layer.name == "albedo" || layer.name == "normal" || layer.name == "depth";
+    });
+}
+
+void ForwardCamera::record_first_hit(FirstHits &hits, const Ray &r, const HitRecord &rec) {
+    hits.albedo += rec.material()->albedo_at(rec);
+    hits.normal += unit_vector(rec.normal);
+    hits.depth += rec.t * r.direction().length();
 }
 
 std::shared_ptr<SampleAggregator> ForwardCamera::render_pixel(const Hittable &world, const Hittable &lights,
                                                              const size_t row, const size_t column) {
-    random_seed(combine(seed, row, column));
+    const auto aggregator = sample_pixel(world, lights, row, column, static_cast<uint32_t>(seed));
+    persist_pixel(row, column, *aggregator);
 
-    const auto aggregator = samplerAggregator->create();
-    aggregator->sample_from(pixelSamplerFactory, static_cast<double>(column), static_cast<double>(row));
+    return aggregator;
+}
 
-    for (const Sample& sample : *aggregator) {
-        Ray r = get_ray(sample.x, sample.y);
+void ForwardCamera::train(const Hittable &world, const Hittable &lights) {
+    const size_t passes = samplingStrategy ? samplingStrategy->training_passes() : 0;
+    const size_t threadCount = numThreads > 0 ? numThreads : std::thread::hardware_concurrency();
 
-        const Color color = rayColor(r, static_cast<int>(maxDepth), world, lights);
-        aggregator->insert_contribution(color);
+    for (size_t pass = 0; pass < passes && !cancelled; ++pass) {
+        const size_t spp = samplingStrategy->training_spp(pass);
+        std::clog << "\rTraining pass " << pass + 1 << "/" << passes << " (" << spp << " spp)   " << std::flush;
+
+        samplingStrategy->begin_pass(world, pass);
+
+        std::atomic<size_t> nextLine{0};
+        auto trainLines = [&]() {
+            for (size_t j = nextLine++; j < imageHeight && !cancelled; j = nextLine++) {
+                // the lines of the image are seeded per pixel, training draws from other sequences
+                random_seed(combine(static_cast<uint32_t>(seed) + static_cast<uint32_t>(pass) + 1, j, 0));
+
+                for (size_t column = 0; column < imageWidth; ++column)
+                    for (size_t s = 0; s < spp; ++s) {
+                        const Ray r = get_ray(static_cast<double>(column) + random_double() - .5,
+                                              static_cast<double>(j) + random_double() - .5);
+                        (void) rayColor(r, static_cast<int>(maxDepth), world, lights);
+                    }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < threadCount; ++t)
+            threads.emplace_back(trainLines);
+        for (auto &t : threads)
+            t.join();
+
+        samplingStrategy->end_pass(pass);
     }
 
-    const Color pixel_color = aggregator->aggregate();
+    if (passes > 0) std::clog << std::endl;
+}
+
+void ForwardCamera::persist_pixel(const size_t row, const size_t column, SampleAggregator &aggregator) {
+    persist_color_to_data(row, column, aggregator.aggregate());
+    if (!imageData->layers.empty()) persist_aovs(row, column, aggregator);
+    if (sampleDump && sampleDump->selected(row, column)) sampleDump->record(row, column, aggregator);
+}
 
-    persist_color_to_data(row, column, pixel_color);
+std::shared_ptr<SampleAggregator> ForwardCamera::sample_pixel(const Hittable &world, const Hittable &lights,
+                                                             const size_t row, const size_t column,
+                                                             const uint32_t seed) const {
+    random_seed(combine(seed, row, column));
+
+    const auto aggregator = samplerAggregator->create();
+    aggregator->sample_from(pixelSamplerFactory, static_cast<double>(column), static_cast<double>(row));
+
+    // the first hits of the samples feed the albedo, normal and depth layers as they are shaded
+    const bool firstHits = records_first_hits();
+
+    if (packetSize > 1) {
+        // the primary rays of the pixel are coherent: they traverse the scene together, then are shaded one by one
+        const size_t size = std::min(packetSize, RayPacket::capacity);
+        const int depth = static_cast<int>(maxDepth);
+        RayPacket packet;
+
+        for (auto it = aggregator->begin(); it != aggregator->end();) {
+            packet.clear();
+            for (; it != aggregator->end() && packet.size < size; ++it)
+                packet.add(get_ray(it->x, it->y));
+            packet.prepare();
+
+            const uint32_t hits = depth > 0 ? world.hit_packet(packet, Interval(0.001, infinity)) : 0;
+
+            for (size_t i = 0; i < packet.size; ++i) {
+                Color color(0, 0, 0);
+                if (hits & (1u << i)) {
+                    color = shade(packet.rays[i], depth, world, lights, packet.records[i]);
+                    if (firstHits) record_first_hit(aggregator->firstHits, packet.rays[i], packet.records[i]);
+                } else if (depth > 0)
+                    color = background;
+                aggregator->insert_contribution(color);
+            }
+        }
+    } else {
+        for (const Sample& sample : *aggregator) {
+            Ray r = get_ray(sample.x, sample.y);
+            HitRecord rec;
+
+            const Color color = rayColor(r, static_cast<int>(maxDepth), world, lights, rec);
+            if (firstHits && rec.mat_id != MaterialTable::none) record_first_hit(aggregator->firstHits, r, rec);
+            aggregator->insert_contribution(color);
+        }
+    }
 
     return aggregator;
 }
@@ -143,27 +305,43 @@ std::shared_ptr<SampleAggregator> ForwardCamera::render_pixel(const Hittable &wo
 
 void ForwardCamera::render(const Hittable& world, const Hittable& lights) {
     initialize();
+    train(world, lights);
+    if (onPrepared) onPrepared();
 
-    for (int j = 0; j < imageHeight; j++) {
+    for (size_t j = 0; j < imageHeight && !cancelled; j++) {
         std::clog << "\rScanlines remaining: " << (imageHeight - j) << ' ' << std::flush;
         render_line(world, lights, j);
+        if (onLinesRendered) onLinesRendered(j, 1);
     }
 }
 
 Color ForwardCamera::rayColor(const Ray& r, const int depth, const Hittable& world, const Hittable& lights) const {
+    HitRecord rec;
+    return rayColor(r, depth, world, lights, rec);
+}
+
+Color ForwardCamera::rayColor(const Ray& r, const int depth, const Hittable& world, const Hittable& lights,
+                              HitRecord& rec) const {
     // If we've exceeded the ray bounce limit, no more light is gathered.
     if (depth <= 0)
         return {0, 0, 0};
 
-    HitRecord rec;
     // If the ray hits nothing, return the background color.
     if (!world.hit(r, Interval(0.001, infinity), rec))
         return background;
 
+    return shade(r, depth, world, lights, rec);
+}
+
+Color ForwardCamera::shade(const Ray& r, const int depth, const Hittable& world, const Hittable& lights,
+                           HitRecord& rec) const {
+    rec.finalize(r);
+    const Material *mat = rec.material();
+
     ScatterRecord scatterRecord;
-    const Color color_from_emission = rec.mat->emitted(r, rec, rec.u, rec.v, rec.p);
+    const Color color_from_emission = mat->emitted(r, rec, rec.u, rec.v, rec.p);
 
-    if (!rec.mat->scatter(r, rec, scatterRecord))
+    if (!mat->scatter(r, rec, scatterRecord))
         return color_from_emission;
 
     if (scatterRecord.skip_pdf) {
@@ -173,8 +351,8 @@ Color ForwardCamera::rayColor(const Ray& r, const int depth, const Hittable& wor
     // Delegate to the sampling strategy
     SamplingStrategy::SamplingContext ctx{r, rec, scatterRecord, world, lights, depth - 1};
 
-    auto ray_color_function = [this, &world, &lights](const Ray& ray, int d) {
-        return this->rayColor(ray, d, world, lights);
+    auto ray_color_function = [this, &world, &lights](const Ray& ray, int d, HitRecord& hit) {
+        return this->rayColor(ray, d, world, lights, hit);
     };
 
     Color colorFromScatter = samplingStrategy->compute_scattered_color(ctx, ray_color_function);
@@ -184,6 +362,8 @@ Color ForwardCamera::rayColor(const Ray& r, const int depth, const Hittable& wor
 
 void ForwardParallelCamera::render(const Hittable &world, const Hittable &lights) {
     initialize();
+    train(world, lights);
+    if (onPrepared) onPrepared();
 
     std::mutex queue_mutex;
 
@@ -195,8 +375,12 @@ void ForwardParallelCamera::render(const Hittable &world, const Hittable &lights
 
     std::queue<std::pair<int, int>> taskQueue;
 
-    for (size_t start_j = 0 ; start_j < imageHeight ; start_j += linesPerBatch) {
-        taskQueue.emplace(start_j, std::min(start_j + linesPerBatch - 1, imageHeight-1));
+    // streamed images are rendered by bands of the sink
+    const size_t batch = tileSink ? tileSink->band_height() : static_cast<size_t>(linesPerBatch);
+    if (tileSink) tileSink->open(imageWidth, imageHeight);
+
+    for (size_t start_j = 0 ; start_j < imageHeight ; start_j += batch) {
+        taskQueue.emplace(start_j, std::min(start_j + batch - 1, imageHeight-1));
     }
     std::clog << std::endl;
 
@@ -208,7 +392,7 @@ void ForwardParallelCamera::render(const Hittable &world, const Hittable &lights
             size_t remainingTasks;
             {
                 std::unique_lock<std::mutex> lock(queue_mutex);
-                if (taskQueue.empty()) {
+                if (taskQueue.empty() || cancelled) {
                     break;  // All the tasks are done!
                 }
                 task = taskQueue.front();
@@ -221,9 +405,25 @@ void ForwardParallelCamera::render(const Hittable &world, const Hittable &lights
             const int start_j = task.first;
             const int end_j = task.second;
 
+            if (!tileSink) {
+                for (int j = start_j; j <= end_j; ++j) {
+                    render_line(world, lights, j);
+                }
+                if (onLinesRendered) onLinesRendered(start_j, end_j - start_j + 1);
+                continue;
+            }
+
+            const size_t rows = end_j - start_j + 1;
+            Band band{static_cast<size_t>(start_j), std::vector<float>(3 * imageWidth * rows)};
+
+            currentBand = &band;
             for (int j = start_j; j <= end_j; ++j) {
                 render_line(world, lights, j);
             }
+            currentBand = nullptr;
+
+            tileSink->write(band.first_row, rows, band.data.data());
+            if (onLinesRendered) onLinesRendered(band.first_row, rows);
         }
     };
 
@@ -236,59 +436,59 @@ void ForwardParallelCamera::render(const Hittable &world, const Hittable &lights
     for (auto& t : threads) {
         t.join();
     }
+
+    if (tileSink) tileSink->close();
     std::clog << std::endl;
 }
 
 CartographyCamera::CartographyCamera(const size_t pixel_x, const size_t pixel_y): pixel_x(pixel_x), pixel_y(pixel_y) {}
 
-void CartographyCamera::render(const Hittable &world, const Hittable &lights) {
-    initialize();
-    render_pixel(world, lights, pixel_y, pixel_x);
-}
-
-void CartographyCamera::initialize() {
-    ForwardCamera::initialize();
+void CartographyCamera::render_line(const Hittable &world, const Hittable &lights, const size_t j) {
+    for (size_t column = 0; column < imageWidth; ++column)
+        render_pixel(world, lights, j, column);
 }
 
 /**
- * Render a pixel cartography. We assume for now that the pixel is uniformly sampled
+ * Renders a cell of the cartography: one ray through the center of the matching sub-position of the mapped pixel.
+ * We assume for now that the pixel is uniformly sampled
  * @param world
  * @param lights
- * @param row
- * @param column
+ * @param row row of the cartography cell
+ * @param column column of the cartography cell
  */
 std::shared_ptr<SampleAggregator> CartographyCamera::render_pixel(const Hittable &world, const Hittable &lights,
                                                                  const size_t row, const size_t column) {
-    std::clog << "Rendering pixel @ " << column << ", " << row << std::endl;
-    for (size_t y = 0 ; y < imageHeight ; ++y) {
-        const double dy = static_cast<double>(y) / static_cast<double>(imageHeight) - .5;
-        for (size_t x = 0 ; x < imageWidth ; ++x) {
-            const double dx = static_cast<double>(x) / static_cast<double>(imageWidth) - .5;
-            Ray r = get_ray(dx + static_cast<double>(column), dy + static_cast<double>(row));
+    random_seed(combine(seed, row, column));
 
-            Color pixel_color = rayColor(r, static_cast<int>(maxDepth), world, lights);
+    const double dx = (static_cast<double>(column) + .5) / static_cast<double>(imageWidth) - .5;
+    const double dy = (static_cast<double>(row) + .5) / static_cast<double>(imageHeight) - .5;
+    const Ray r = get_ray(dx + static_cast<double>(pixel_x), dy + static_cast<double>(pixel_y));
 
-            persist_color_to_data(row, column, pixel_color);
-        }
-    }
+    persist_color_to_data(row, column, rayColor(r, static_cast<int>(maxDepth), world, lights));
 
     return nullptr;
 }
 
-std::shared_ptr<SampleAggregator> BiasedForwardParallelCamera::render_pixel(
-    const Hittable &world, const Hittable &lights, size_t row, size_t column) {
+std::shared_ptr<SampleAggregator> BiasedForwardParallelCamera::sample_pixel(
+    const Hittable &world, const Hittable &lights, size_t row, size_t column, const uint32_t seed) const {
+    random_seed(combine(seed, row, column));
+
     const auto aggregator = samplerAggregator->create();
     aggregator->sample_from(pixelSamplerFactory, static_cast<double>(column), static_cast<double>(row));
 
+    const bool firstHits = records_first_hits();
+
     for (const Sample& sample : *aggregator) {
         Ray r = get_ray(sample.x, sample.y);
 
         size_t retries = 0;
         Color color;
+        HitRecord rec;
 
         do {
-            color = rayColor(r, static_cast<int>(maxDepth), world, lights);
+            color = rayColor(r, static_cast<int>(maxDepth), world, lights, rec);
         } while (color.near_zero() && ++retries < 20);
+        if (firstHits && rec.mat_id != MaterialTable::none) record_first_hit(aggregator->firstHits, r, rec);
         aggregator->insert_contribution(color);
     }
 
@@ -306,10 +506,6 @@ std::shared_ptr<SampleAggregator> BiasedForwardParallelCamera::render_pixel(
     //     aggregator->insert_contribution(color);
     // }
 
-    const Color pixel_color = aggregator->aggregate();
-
-    persist_color_to_data(row, column, pixel_color);
-
     return aggregator;
 }
 
@@ -317,34 +513,38 @@ std::shared_ptr<SampleAggregator> BiasedForwardParallelCamera::render_pixel(
 FunctionCamera::FunctionCamera(shared_ptr<Function> function): ForwardParallelCamera(), function(function) {}
 
 
-std::shared_ptr<SampleAggregator> FunctionCamera::render_pixel(const Hittable &world, const Hittable &lights, size_t row, size_t column) {
+std::shared_ptr<SampleAggregator> FunctionCamera::sample_pixel(const Hittable &world, const Hittable &lights,
+                                                              size_t row, size_t column, const uint32_t seed) const {
     random_seed(combine(seed, row, column));
 
     const auto aggregator = samplerAggregator->create();
     aggregator->sample_from(pixelSamplerFactory, static_cast<double>(column), static_cast<double>(row));
+    // the whole pixel is evaluated in one batch
+    const auto count = static_cast<size_t>(aggregator->end() - aggregator->begin());
+    std::pmr::vector<double> xs(count, PixelArena::resource());
+    std::pmr::vector<double> ys(count, PixelArena::resource());
+    std::pmr::vector<double> values(count, PixelArena::resource());
+
+    size_t i = 0;
     for (const Sample& sample : *aggregator) {
-        const double value = function->compute(sample.dx, sample.dy);
-        const Color color(value, value, value);
-        aggregator->insert_contribution(color);
+        xs[i] = sample.dx;
+        ys[i] = sample.dy;
+        ++i;
     }
 
-    const Color pixel_color = aggregator->aggregate();
+    function->compute_batch(xs.data(), ys.data(), values.data(), count);
 
-    persist_color_to_data(row, column, pixel_color);
+    for (const double value : values) {
+        const Color color(value, value, value);
+        aggregator->insert_contribution(color);
+    }
 
     return aggregator;
 }
 #endif
 
-Color NormalCamera::rayColor(const Ray &r, int depth, const Hittable &world, const Hittable &lights) const {
-    if (depth <= 0)
-        return {0, 0, 0};
-
-    HitRecord rec;
-    // If the ray hits nothing, return the background color.
-    if (!world.hit(r, Interval(0.001, infinity), rec))
-        return background;
-
+Color NormalCamera::shade(const Ray &r, int depth, const Hittable &world, const Hittable &lights, HitRecord &rec) const {
+    rec.finalize(r);
     const auto n = unit_vector(rec.normal);
 
     double red = (n.x() + 1.) / 2.;
@@ -356,21 +556,32 @@ Color NormalCamera::rayColor(const Ray &r, int depth, const Hittable &world, con
 
 void SinglePixelCamera::render(const Hittable &world, const Hittable &lights) {
     initialize();
+    if (onPrepared) onPrepared();
+    if (cancelled) return;
 
     render_pixel(world, lights, pixel_y, pixel_x);
 
     const size_t idx = 3 * (pixel_x + pixel_y * imageWidth);
 
-    imageData.data[0] = imageData.data[idx];
-    imageData.data[1] = imageData.data[idx + 1];
-    imageData.data[2] = imageData.data[idx + 2];
+    imageData->data[0] = imageData->data[idx];
+    imageData->data[1] = imageData->data[idx + 1];
+    imageData->data[2] = imageData->data[idx + 2];
 
+    const size_t imageWidthBefore = imageWidth;
     imageHeight = 1;
     imageWidth = 1;
 
-    imageData.data.resize(3);
-    imageData.width = 1;
-    imageData.height = 1;
+    imageData->data.resize(3);
+    imageData->width = 1;
+    imageData->height = 1;
+
+    for (auto &layer : imageData->layers) {
+        const size_t first = layer.channels * (pixel_x + pixel_y * imageWidthBefore);
+        std::copy_n(layer.data.begin() + first, layer.channels, layer.data.begin());
+        layer.data.resize(layer.channels);
+    }
+
+    if (onLinesRendered) onLinesRendered(0, 1);
 }
 
 SinglePixelCamera::SinglePixelCamera(const size_t pixel_x, const size_t pixel_y): pixel_x(pixel_x), pixel_y(pixel_y) {}
@@ -0,0 +1,127 @@
+/*
+ * This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
+ * Copyright (c) 2025 PrISE-3D.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * --- ADDITIONAL PERMISSION UNDER GNU GPL VERSION 3 SECTION 7 ---
+ *
+ * If you modify this Program, or any covered work, by linking or
+ * combining it with the Intel Math Kernel Library (MKL) (or a modified
+ * version of that library), containing parts covered by the terms of
+ * the Intel Simplified Software License, the licensors of this
+ * Program grant you additional permission to convey the resulting work.
+ */
+
+#include "denoiser.h"
+#include "image_data.h"
+#include <algorithm>
+#include <iostream>
+#include <torch/script.h>
+
+namespace {
+    /**
+     * Sets the intra-op threads of libtorch, which are process wide, until the end of the scope
+     */
+    struct ThreadsScope {
+        explicit ThreadsScope(const int threads): previous(at::get_num_threads()) {
+            at::set_num_threads(threads);
+        }
+
+        ~ThreadsScope() {
+            at::set_num_threads(previous);
+        }
+
+        int previous;
+    };
+}
+
+struct Denoiser::Model {
+    torch::jit::script::Module module;
+};
+
+Denoiser::Denoiser(const std::filesystem::path &path, const int numThreads, const std::size_t tileSize,
+                   const std::size_t overlap):
+    model(std::make_unique<Model>()), numThreads(std::max(1, numThreads)), tileSize(std::max<std::size_t>(1, tileSize)),
+    overlap(overlap) {
+    model->module = torch::jit::load(path.string(), torch::Device(torch::kCPU));
+    model->module.eval();
+}
+
+Denoiser::~Denoiser() = default;
+
+bool Denoiser::denoise(ImageData &image) const {
+    const ImageData::Layer *albedo = image.layer("albedo");
+    const ImageData::Layer *normal = image.layer("normal");
+
+    if (albedo == nullptr || normal == nullptr || albedo->channels != 3 || normal->channels != 3) {
+        std::cerr << "denoising needs the albedo and normal AOVs, the image is kept as rendered." << std::endl;
+        return false;
+    }
+
+    const auto height = static_cast<int64_t>(image.height);
+    const auto width = static_cast<int64_t>(image.width);
+
+    // the threads of the aggregation model, if any, are restored for the next renders
+    const ThreadsScope threads(numThreads);
+    c10::InferenceMode inference;
+
+    // the buffers are row major rgb: viewed as [h, w, 3] without copying
+    const auto view = [height, width](const std::vector<float> &data) {
+        return torch::from_blob(const_cast<float *>(data.data()), {height, width, 3}, torch::kFloat32);
+    };
+    const torch::Tensor beauty = view(image.data);
+    const torch::Tensor albedos = view(albedo->data);
+    const torch::Tensor normals = view(normal->data);
+
+    // tiles read the noisy beauty around them: the result goes to another buffer
+    std::vector<float> denoised(image.data.size());
+    torch::Tensor output = torch::from_blob(denoised.data(), {height, width, 3}, torch::kFloat32);
+
+    const auto tile = static_cast<int64_t>(tileSize);
+    const auto margin = static_cast<int64_t>(overlap);
+
+    for (int64_t y0 = 0; y0 < height; y0 += tile) {
+        const int64_t y1 = std::min(height, y0 + tile);
+        const int64_t top = std::max<int64_t>(0, y0 - margin);
+        const int64_t bottom = std::min(height, y1 + margin);
+
+        for (int64_t x0 = 0; x0 < width; x0 += tile) {
+            const int64_t x1 = std::min(width, x0 + tile);
+            const int64_t left = std::max<int64_t>(0, x0 - margin);
+            const int64_t right = std::min(width, x1 + margin);
+
+            // only the tile is concatenated, the guides of the whole image are never copied at once
+            const auto crop = [=](const torch::Tensor &layer) {
+                return layer.slice(0, top, bottom).slice(1, left, right);
+            };
+            const torch::Tensor input = torch::cat({crop(beauty), crop(albedos), crop(normals)}, 2)
+                                              .permute({2, 0, 1}).unsqueeze(0).contiguous();
+
+            const torch::Tensor result = model->module.forward({input}).toTensor();
+
+            if (result.dim() != 4 || result.size(0) != 1 || result.size(1) != 3 ||
+                result.size(2) != bottom - top || result.size(3) != right - left) {
+                std::cerr << "the denoiser returned a tensor of shape " << result.sizes() << " instead of [1, 3, "
+                          << bottom - top << ", " << right - left << "], the image is kept as rendered." << std::endl;
+                return false;
+            }
+
+            output.slice(0, y0, y1).slice(1, x0, x1)
+                  .copy_(result.squeeze(0).permute({1, 2, 0})
+                               .slice(0, y0 - top, y1 - top).slice(1, x0 - left, x1 - left));
+        }
+    }
+
+    image.data = std::move(denoised);
+    return true;
+}
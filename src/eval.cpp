@@ -23,6 +23,55 @@
  */
 
 #include "parser.h"
+#include "arena.h"
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+/**
+ * Writes the replica estimates in run order as they complete, either as text (.csv) or as raw doubles (any other
+ * extension, three per run)
+ */
+class ReplicaWriter {
+public:
+    ReplicaWriter(const std::filesystem::path &path, const std::size_t runs): values(runs), done(runs, false) {
+        if (path.empty()) return;
+        binary = path.extension() != ".csv";
+        out.open(path, binary ? std::ios::binary : std::ios::out);
+        if (!binary) {
+            out.precision(17);
+            out << "run,r,g,b" << std::endl;
+        }
+    }
+
+    void store(const std::size_t run, const Color &value) {
+        std::lock_guard lock(mutex);
+        values[run] = value;
+        done[run] = true;
+
+        for (; next < values.size() && done[next]; ++next) {
+            if (!out.is_open()) continue;
+            const Color &c = values[next];
+            if (binary) {
+                const double rgb[3] = {c.x(), c.y(), c.z()};
+                out.write(reinterpret_cast<const char *>(rgb), sizeof(rgb));
+            } else {
+                out << next << ',' << c.x() << ',' << c.y() << ',' << c.z() << '\n';
+            }
+        }
+    }
+
+    const std::vector<Color> &estimates() const { return values; }
+
+private:
+    std::vector<Color> values;
+    std::vector<bool> done;
+    std::size_t next = 0;
+    bool binary = false;
+    std::ofstream out;
+    std::mutex mutex;
+};
 
 int main(int argc, char *argv[]) {
     Parser parser;
@@ -31,12 +80,85 @@ int main(int argc, char *argv[]) {
     // load the scene description and camera
     if (!parser.parseScene(argc, argv, scene)) return 0;
 
+    // the pixel is sampled without training passes, a guide would never learn anything
+    const auto &strategy = scene.camera->samplingStrategy;
+    if (strategy && strategy->training_passes() > 0) {
+        std::cerr << "The evaluation does not train the sampling strategy, guiding is ignored." << std::endl;
+        if (strategy->uses_nee()) scene.camera->samplingStrategy = std::make_shared<NEESamplingStrategy>();
+        else scene.camera->samplingStrategy = std::make_shared<MixtureSamplingStrategy>();
+    }
+
+    std::size_t runs = 1;
+    std::filesystem::path valuesPath;
+
+    const std::string runsprefix = "runs=";
+    const std::string valuesprefix = "values=";
+
+    for (int i = 1 ; i < argc ; i++) {
+        std::string parameter(argv[i]);
+
+        if (parameter.rfind(runsprefix, 0) == 0) {
+            runs = std::max(1ul, std::stoul(parameter.substr(runsprefix.size())));
+        } else if (parameter.rfind(valuesprefix, 0) == 0) {
+            valuesPath = parameter.substr(valuesprefix.size());
+        }
+    }
+
     scene.camera->imageWidth = 1;
     scene.camera->initialize();
 
-    scene.camera->render_pixel(*scene.content, *scene.lights, 0, 0);
-    auto data = scene.camera->data();
-    auto v = data->data[0];
+    if (runs == 1 && valuesPath.empty()) {
+        scene.camera->render_pixel(*scene.content, *scene.lightSampler, 0, 0);
+        auto data = scene.camera->data();
+        auto v = data->data[0];
+
+        std::cout << std::endl << v << std::endl;
+        return 0;
+    }
+
+    // independent replicas of the pixel, run i being seeded with seed + i
+    ReplicaWriter writer(valuesPath, runs);
+    std::atomic<std::size_t> next{0};
+    const auto seed = static_cast<uint32_t>(scene.camera->seed);
+
+    auto worker = [&]() {
+        for (std::size_t run = next++; run < runs; run = next++) {
+            PixelArena::Scope scope;
+            const auto aggregator = scene.camera->sample_pixel(*scene.content, *scene.lightSampler, 0, 0,
+                                                               seed + static_cast<uint32_t>(run));
+            writer.store(run, aggregator->aggregate());
+        }
+    };
+
+    std::size_t numThreads = scene.camera->numThreads;
+    if (numThreads == 0) numThreads = std::thread::hardware_concurrency();
+    numThreads = std::max<std::size_t>(1, std::min(numThreads, runs));
+
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < numThreads; ++t)
+        threads.emplace_back(worker);
+    for (auto &thread : threads)
+        thread.join();
+
+    // per channel mean, unbiased variance and 95% confidence interval of the mean
+    const auto &estimates = writer.estimates();
+    const auto n = static_cast<double>(runs);
+
+    Color mean(0, 0, 0);
+    for (const auto &e : estimates) mean += e;
+    mean /= n;
+
+    Color variance(0, 0, 0);
+    for (const auto &e : estimates) variance += (e - mean) * (e - mean);
+    if (runs > 1) variance /= n - 1;
+
+    std::cout.precision(10);
+    std::cout << std::endl << "runs: " << runs << std::endl;
 
-    std::cout << std::endl << v << std::endl;
+    const char *channels[3] = {"r", "g", "b"};
+    for (int c = 0; c < 3; ++c) {
+        const double half = 1.96 * std::sqrt(variance[c] / n);
+        std::cout << channels[c] << ": mean " << mean[c] << " variance " << variance[c]
+                  << " 95% CI [" << mean[c] - half << ", " << mean[c] + half << "]" << std::endl;
+    }
 }
@@ -0,0 +1,357 @@
+/*
+ * This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
+ * Copyright (c) 2025 PrISE-3D.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * --- ADDITIONAL PERMISSION UNDER GNU GPL VERSION 3 SECTION 7 ---
+ *
+ * If you modify this Program, or any covered work, by linking or
+ * combining it with the Intel Math Kernel Library (MKL) (or a modified
+ * version of that library), containing parts covered by the terms of
+ * the Intel Simplified Software License, the licensors of this
+ * Program grant you additional permission to convey the resulting work.
+ */
+
+#include "function_program.h"
+#include "arena.h"
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <memory_resource>
+#include <sstream>
+
+// ============================================================================
+// Parser
+// ============================================================================
+
+/**
+ * Recursive descent parser emitting the program in postfix order. Precedence, from lowest: comparisons, + -,
+ * * /, unary -, ^ (right associative).
+ */
+class FunctionProgram::Parser {
+public:
+    Parser(const std::string &source, FunctionProgram &program) : source(source), program(program) {}
+
+    bool parse() {
+        if (!comparison()) return false;
+        skip_spaces();
+        return position == source.size();
+    }
+
+private:
+    const std::string &source;
+    FunctionProgram &program;
+    std::size_t position = 0;
+    std::size_t stack = 0;
+
+    void emit(const Op op, const double value = 0.) {
+        program.code.push_back({op, value});
+
+        switch (op) {
+            case Op::X: case Op::Y: case Op::Constant:
+                program.depth = std::max(program.depth, ++stack);
+                break;
+            case Op::Neg: case Op::Sin: case Op::Cos: case Op::Tan: case Op::Abs: case Op::Sqrt: case Op::Exp:
+            case Op::Log: case Op::Frac: case Op::PowConstant:
+                break;
+            default:
+                --stack;
+        }
+    }
+
+    void skip_spaces() {
+        while (position < source.size() && std::isspace(static_cast<unsigned char>(source[position])))
+            ++position;
+    }
+
+    bool accept(const std::string &token) {
+        skip_spaces();
+        if (source.compare(position, token.size(), token) != 0)
+            return false;
+        position += token.size();
+        return true;
+    }
+
+    bool comparison() {
+        if (!additive()) return false;
+
+        while (true) {
+            Op op;
+            if (accept("<=")) op = Op::Le;
+            else if (accept(">=")) op = Op::Ge;
+            else if (accept("<")) op = Op::Lt;
+            else if (accept(">")) op = Op::Gt;
+            else return true;
+
+            if (!additive()) return false;
+            emit(op);
+        }
+    }
+
+    bool additive() {
+        if (!multiplicative()) return false;
+
+        while (true) {
+            Op op;
+            if (accept("+")) op = Op::Add;
+            else if (accept("-")) op = Op::Sub;
+            else return true;
+
+            if (!multiplicative()) return false;
+            emit(op);
+        }
+    }
+
+    bool multiplicative() {
+        if (!unary()) return false;
+
+        while (true) {
+            Op op;
+            if (accept("*")) op = Op::Mul;
+            else if (accept("/")) op = Op::Div;
+            else return true;
+
+            if (!unary()) return false;
+            emit(op);
+        }
+    }
+
+    bool unary() {
+        if (accept("-")) {
+            if (!unary()) return false;
+            emit(Op::Neg);
+            return true;
+        }
+        if (accept("+"))
+            return unary();
+        return power();
+    }
+
+    bool power() {
+        if (!primary()) return false;
+
+        if (accept("^")) {
+            // right associative, the exponent may carry its own sign
+            if (!unary()) return false;
+
+            // constant exponents (mostly squares) avoid std::pow
+            if (program.code.back().op == Op::Constant) {
+                const double exponent = program.code.back().value;
+                program.code.pop_back();
+                --stack;
+                emit(Op::PowConstant, exponent);
+            } else {
+                emit(Op::Pow);
+            }
+        }
+        return true;
+    }
+
+    bool primary() {
+        skip_spaces();
+        if (position >= source.size()) return false;
+
+        const char c = source[position];
+
+        if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
+            const char *start = source.c_str() + position;
+            char *end;
+            const double value = std::strtod(start, &end);
+            if (end == start) return false;
+            position += end - start;
+            emit(Op::Constant, value);
+            return true;
+        }
+
+        if (accept("(")) {
+            if (!comparison()) return false;
+            return accept(")");
+        }
+
+        if (!std::isalpha(static_cast<unsigned char>(c))) return false;
+
+        std::size_t end = position;
+        while (end < source.size() && (std::isalnum(static_cast<unsigned char>(source[end])) || source[end] == '_'))
+            ++end;
+        const std::string name = source.substr(position, end - position);
+        position = end;
+
+        if (name == "x") { emit(Op::X); return true; }
+        if (name == "y") { emit(Op::Y); return true; }
+        if (name == "pi") { emit(Op::Constant, pi); return true; }
+
+        Op op;
+        if (name == "sin") op = Op::Sin;
+        else if (name == "cos") op = Op::Cos;
+        else if (name == "tan") op = Op::Tan;
+        else if (name == "abs") op = Op::Abs;
+        else if (name == "sqrt") op = Op::Sqrt;
+        else if (name == "exp") op = Op::Exp;
+        else if (name == "log") op = Op::Log;
+        else if (name == "frac") op = Op::Frac;
+        else return false;  // unsupported function or variable (eg. RND)
+
+        if (!accept("(") || !comparison() || !accept(")")) return false;
+        emit(op);
+        return true;
+    }
+};
+
+// ============================================================================
+// FunctionProgram
+// ============================================================================
+
+namespace {
+    // raises n values to a constant power
+    void power(double *a, const std::size_t n, const double exponent) {
+        if (exponent == 2.) {
+            for (std::size_t i = 0; i < n; ++i) a[i] *= a[i];
+        } else if (exponent == 3.) {
+            for (std::size_t i = 0; i < n; ++i) a[i] *= a[i] * a[i];
+        } else if (exponent == .5) {
+            for (std::size_t i = 0; i < n; ++i) a[i] = std::sqrt(a[i]);
+        } else {
+            for (std::size_t i = 0; i < n; ++i) a[i] = std::pow(a[i], exponent);
+        }
+    }
+}
+
+shared_ptr<FunctionProgram> FunctionProgram::compile(const std::string &source) {
+    auto program = make_shared<FunctionProgram>();
+    Parser parser(source, *program);
+
+    if (!parser.parse())
+        return nullptr;
+    return program;
+}
+
+void FunctionProgram::evaluate(const double *x, const double *y, double *out, const std::size_t n) const {
+    if (n == 0) return;
+
+    // one column of n values per stack slot
+    std::pmr::vector<double> stack(depth * n, PixelArena::resource());
+    std::size_t top = 0;  // number of columns in use
+
+    for (const auto &[op, value] : code) {
+        double *b = stack.data() + top * n;  // column pushed next, or right operand after pop
+
+        switch (op) {
+            case Op::X:
+                std::copy(x, x + n, b);
+                ++top;
+                continue;
+            case Op::Y:
+                std::copy(y, y + n, b);
+                ++top;
+                continue;
+            case Op::Constant:
+                std::fill(b, b + n, value);
+                ++top;
+                continue;
+            default:
+                break;
+        }
+
+        // operators have their operands on the stack: top is at least 1 for unary and 2 for binary ones
+        if (op >= Op::Add && op <= Op::Ge) {
+            --top;
+            b -= n;
+        }
+        double *a = stack.data() + (top - 1) * n;  // unary operand, or left operand of a binary operator
+
+        switch (op) {
+            case Op::Add: for (std::size_t i = 0; i < n; ++i) a[i] += b[i]; break;
+            case Op::Sub: for (std::size_t i = 0; i < n; ++i) a[i] -= b[i]; break;
+            case Op::Mul: for (std::size_t i = 0; i < n; ++i) a[i] *= b[i]; break;
+            case Op::Div: for (std::size_t i = 0; i < n; ++i) a[i] /= b[i]; break;
+            case Op::Pow: for (std::size_t i = 0; i < n; ++i) a[i] = std::pow(a[i], b[i]); break;
+            case Op::Lt: for (std::size_t i = 0; i < n; ++i) a[i] = a[i] < b[i] ? 1. : 0.; break;
+            case Op::Le: for (std::size_t i = 0; i < n; ++i) a[i] = a[i] <= b[i] ? 1. : 0.; break;
+            case Op::Gt: for (std::size_t i = 0; i < n; ++i) a[i] = a[i] > b[i] ? 1. : 0.; break;
+            case Op::Ge: for (std::size_t i = 0; i < n; ++i) a[i] = a[i] >= b[i] ? 1. : 0.; break;
+            case Op::Neg: for (std::size_t i = 0; i < n; ++i) a[i] = -a[i]; break;
+            case Op::Sin: for (std::size_t i = 0; i < n; ++i) a[i] = std::sin(a[i]); break;
+            case Op::Cos: for (std::size_t i = 0; i < n; ++i) a[i] = std::cos(a[i]); break;
+            case Op::Tan: for (std::size_t i = 0; i < n; ++i) a[i] = std::tan(a[i]); break;
+            case Op::Abs: for (std::size_t i = 0; i < n; ++i) a[i] = std::fabs(a[i]); break;
+            case Op::Sqrt: for (std::size_t i = 0; i < n; ++i) a[i] = std::sqrt(a[i]); break;
+            case Op::Exp: for (std::size_t i = 0; i < n; ++i) a[i] = std::exp(a[i]); break;
+            case Op::Log: for (std::size_t i = 0; i < n; ++i) a[i] = std::log(a[i]); break;
+            case Op::Frac: for (std::size_t i = 0; i < n; ++i) a[i] -= std::trunc(a[i]); break;
+            case Op::PowConstant: power(a, n, value); break;
+            default: break;
+        }
+    }
+
+    std::copy(stack.data(), stack.data() + n, out);
+}
+
+std::string FunctionProgram::to_cpp() const {
+    std::vector<std::string> stack;
+
+    const auto literal = [](const double value) {
+        std::ostringstream out;
+        out.precision(17);
+        out << value;
+        // keeps the literal a double
+        if (out.str().find_first_of(".eEn") == std::string::npos) out << ".";
+        return out.str();
+    };
+
+    for (const auto &[op, value] : code) {
+        switch (op) {
+            case Op::X: stack.emplace_back("x"); continue;
+            case Op::Y: stack.emplace_back("y"); continue;
+            case Op::Constant: stack.push_back("(" + literal(value) + ")"); continue;
+            default: break;
+        }
+
+        std::string &a = stack.back();
+
+        if (op >= Op::Add && op <= Op::Ge) {
+            const std::string b = stack.back();
+            stack.pop_back();
+            std::string &l = stack.back();
+
+            switch (op) {
+                case Op::Add: l = "(" + l + " + " + b + ")"; break;
+                case Op::Sub: l = "(" + l + " - " + b + ")"; break;
+                case Op::Mul: l = "(" + l + " * " + b + ")"; break;
+                case Op::Div: l = "(" + l + " / " + b + ")"; break;
+                case Op::Pow: l = "std::pow(" + l + ", " + b + ")"; break;
+                case Op::Lt: l = "yapt_compare(" + l + " < " + b + ")"; break;
+                case Op::Le: l = "yapt_compare(" + l + " <= " + b + ")"; break;
+                case Op::Gt: l = "yapt_compare(" + l + " > " + b + ")"; break;
+                case Op::Ge: l = "yapt_compare(" + l + " >= " + b + ")"; break;
+                default: break;
+            }
+            continue;
+        }
+
+        switch (op) {
+            case Op::Neg: a = "(-" + a + ")"; break;
+            case Op::Sin: a = "std::sin(" + a + ")"; break;
+            case Op::Cos: a = "std::cos(" + a + ")"; break;
+            case Op::Tan: a = "std::tan(" + a + ")"; break;
+            case Op::Abs: a = "std::fabs(" + a + ")"; break;
+            case Op::Sqrt: a = "std::sqrt(" + a + ")"; break;
+            case Op::Exp: a = "std::exp(" + a + ")"; break;
+            case Op::Log: a = "std::log(" + a + ")"; break;
+            case Op::Frac: a = "yapt_frac(" + a + ")"; break;
+            case Op::PowConstant: a = "yapt_power(" + a + ", " + literal(value) + ")"; break;
+            default: break;
+        }
+    }
+
+    return stack.back();
+}
@@ -24,6 +24,7 @@
 
 #include "hittable_list.h"
 #include "hittable.h"
+#include "ray_packet.h"
 #include <memory>
 
 using std::shared_ptr;
@@ -41,21 +42,37 @@ void HittableList::add(const shared_ptr<Hittable> &object) {
 }
 
 bool HittableList::hit(const Ray &r, Interval ray_t, HitRecord &record) const {
-    HitRecord temp_rec;
     bool hit_anything = false;
     auto closest_so_far = ray_t.max;
 
+    // hittables only write the record when they are hit closer than the current interval: no copy needed
     for (const auto &object: objects) {
-        if (object->hit(r, Interval(ray_t.min, closest_so_far), temp_rec)) {
+        if (object->hit(r, Interval(ray_t.min, closest_so_far), record)) {
             hit_anything = true;
-            closest_so_far = temp_rec.t;
-            record = temp_rec;
+            closest_so_far = record.t;
         }
     }
 
+    if (hit_anything && light_id >= 0)
+        record.light_id = light_id;
+
     return hit_anything;
 }
 
+uint32_t HittableList::hit_packet(RayPacket &packet, const Interval ray_t) const {
+    uint32_t hits = 0;
+
+    for (const auto &object: objects)
+        hits |= object->hit_packet(packet, ray_t);
+
+    if (light_id >= 0)
+        for (std::size_t i = 0; i < packet.size; ++i)
+            if (hits & (1u << i))
+                packet.records[i].light_id = light_id;
+
+    return hits;
+}
+
 AABB HittableList::bounding_box() const { return bbox; }
 
 double HittableList::pdfValue(const Point3 &origin, const Vec3 &direction) const {
@@ -71,4 +88,13 @@ double HittableList::pdfValue(const Point3 &origin, const Vec3 &direction) const
 Vec3 HittableList::random(const Point3 &origin) const {
     auto int_size = int(objects.size());
     return objects[random_int(0, int_size - 1)]->random(origin);
-}
\ No newline at end of file
+}
+
+double HittableList::power() const {
+    auto sum = 0.0;
+
+    for (const auto &object: objects)
+        sum += object->power();
+
+    return sum;
+}
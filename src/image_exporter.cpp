@@ -27,10 +27,16 @@
 #include <memory>
 #include <iostream>
 #include <vector>
-#include <ImfRgbaFile.h>
-#include <ImfArray.h>
+#include <algorithm>
+#include <thread>
 #include <ImfHeader.h>
 #include <ImfIntAttribute.h>
+#include <ImfChannelList.h>
+#include <ImfCompression.h>
+#include <ImfFrameBuffer.h>
+#include <ImfOutputFile.h>
+#include <ImfTiledOutputFile.h>
+#include <ImfThreading.h>
 
 using std::shared_ptr;
 
@@ -99,33 +105,202 @@ void PNGImageExporter::write(std::string fileName) {
     }
 }
 
+inline bool exr_compression(const std::string &name, Imf::Compression &compression) {
+    static const std::pair<const char *, Imf::Compression> codecs[] = {
+        {"none", Imf::NO_COMPRESSION}, {"rle", Imf::RLE_COMPRESSION}, {"zips", Imf::ZIPS_COMPRESSION},
+        {"zip", Imf::ZIP_COMPRESSION}, {"piz", Imf::PIZ_COMPRESSION}, {"pxr24", Imf::PXR24_COMPRESSION},
+        {"b44", Imf::B44_COMPRESSION}, {"b44a", Imf::B44A_COMPRESSION}, {"dwaa", Imf::DWAA_COMPRESSION},
+        {"dwab", Imf::DWAB_COMPRESSION}
+    };
+
+    for (const auto &[codec, value] : codecs) {
+        if (name == codec) {
+            compression = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+inline Imf::Header exr_header(const int width, const int height, const bool halfChannels,
+                              const Imf::Compression codec) {
+    const Imath_3_1::Box2i dataWindow(Imath_3_1::V2i(0, 0), Imath_3_1::V2i(width - 1, height - 1));
+    const Imath_3_1::Box2i displayWindow(Imath_3_1::V2i(0, 0), Imath_3_1::V2i(width - 1, height - 1));
+
+    Imf_3_2::Header header(displayWindow, dataWindow);
+    header.compression() = codec;
+
+    const Imf::PixelType type = halfChannels ? Imf::HALF : Imf::FLOAT;
+    header.channels().insert("R", Imf::Channel(type));
+    header.channels().insert("G", Imf::Channel(type));
+    header.channels().insert("B", Imf::Channel(type));
+
+    return header;
+}
+
 void EXRImageExporter::write(std::string fileName) {
 
-    const int width = image_data->width;
-    const int height = image_data->height;
+    const int width = static_cast<int>(image_data->width);
+    const int height = static_cast<int>(image_data->height);
+
+    // the render is not lost to a typo: an unknown codec falls back to zip, as for streamed images
+    Imf::Compression codec = Imf::ZIP_COMPRESSION;
+    if (!exr_compression(compression, codec))
+        std::cerr << "unknown EXR compression " << compression << ", using zip" << std::endl;
+
+    try {
+        Imf::setGlobalThreadCount(numThreads > 0 ? numThreads : static_cast<int>(std::thread::hardware_concurrency()));
+
+        Imf::Header header = exr_header(width, height, halfChannels, codec);
+        header.insert("render_time", Imf_3_2::IntAttribute(static_cast<int>(renderTime)));
 
-    Imf::Array2D<Imf::Rgba> pixels(width, height);
-    for (int y = 0 ; y < height ; y++) {
-        for (int x = 0 ; x < width ; x++) {
-            const double r = image_data->data[3*(y * width + x)];
-            const double g = image_data->data[3*(y * width + x) + 1];
-            const double b = image_data->data[3*(y * width + x) + 2];
-            pixels[y][x] = Imf::Rgba(r, g, b);
+        // the slices read the framebuffer in place, the library converting to half when needed
+        const size_t xStride = 3 * sizeof(float);
+        char *beauty = reinterpret_cast<char *>(image_data->data.data());
+
+        Imf::FrameBuffer frameBuffer;
+        frameBuffer.insert("R", Imf::Slice(Imf::FLOAT, beauty, xStride, xStride * width));
+        frameBuffer.insert("G", Imf::Slice(Imf::FLOAT, beauty + sizeof(float), xStride, xStride * width));
+        frameBuffer.insert("B", Imf::Slice(Imf::FLOAT, beauty + 2 * sizeof(float), xStride, xStride * width));
+
+        // extra layers: name.R, name.G and name.B, or name alone for single channel layers
+        const Imf::PixelType type = halfChannels ? Imf::HALF : Imf::FLOAT;
+        const char *suffixes[3] = {".R", ".G", ".B"};
+
+        for (auto &layer : image_data->layers) {
+            const size_t stride = layer.channels * sizeof(float);
+            char *base = reinterpret_cast<char *>(layer.data.data());
+
+            for (size_t c = 0; c < layer.channels; ++c) {
+                const std::string name = layer.channels == 1 ? layer.name : layer.name + suffixes[c % 3];
+                header.channels().insert(name, Imf::Channel(type));
+                frameBuffer.insert(name, Imf::Slice(Imf::FLOAT, base + c * sizeof(float), stride, stride * width));
+            }
+        }
+
+        if (tileSize > 0) {
+            header.setTileDescription(Imf::TileDescription(tileSize, tileSize, Imf::ONE_LEVEL));
+
+            Imf::TiledOutputFile file(fileName.c_str(), header);
+            file.setFrameBuffer(frameBuffer);
+            file.writeTiles(0, file.numXTiles() - 1, 0, file.numYTiles() - 1);
+        } else {
+            Imf::OutputFile file(fileName.c_str(), header);
+            file.setFrameBuffer(frameBuffer);
+            file.writePixels(height);
         }
+    } catch (const std::exception &e) {
+        std::cerr << "error writing image file " <<  fileName << ": " << e.what() << std::endl;
     }
+}
+
+// ============================================================================
+// EXRTileSink
+// ============================================================================
+
+struct EXRTileSink::File {
+    Imf::TiledOutputFile output;
+
+    File(const char *fileName, const Imf::Header &header): output(fileName, header) {}
+};
+
+EXRTileSink::EXRTileSink(std::string fileName, const bool halfChannels, std::string compression, const int tileSize,
+                         const int numThreads):
+    fileName(std::move(fileName)), halfChannels(halfChannels), compression(std::move(compression)),
+    tileSize(std::max(1, tileSize)), numThreads(numThreads) {}
+
+EXRTileSink::~EXRTileSink() = default;
+
+void EXRTileSink::open(const size_t width, const size_t height) {
+    this->width = width;
+
+    Imf::Compression codec = Imf::ZIP_COMPRESSION;
+    if (!exr_compression(compression, codec))
+        std::cerr << "unknown EXR compression " << compression << ", using zip" << std::endl;
+
+    Imf::setGlobalThreadCount(numThreads > 0 ? numThreads : static_cast<int>(std::thread::hardware_concurrency()));
+
+    Imf::Header header = exr_header(static_cast<int>(width), static_cast<int>(height), halfChannels, codec);
+    header.setTileDescription(Imf::TileDescription(tileSize, tileSize, Imf::ONE_LEVEL));
+    // the bands complete in any order
+    header.lineOrder() = Imf::RANDOM_Y;
 
     try {
-        const Imath_3_1::Box2i dataWindow(Imath_3_1::V2i(0, 0), Imath_3_1::V2i(width - 1, height - 1));
-        const Imath_3_1::Box2i displayWindow(Imath_3_1::V2i(0, 0), Imath_3_1::V2i(width - 1, height - 1));
+        file = std::make_unique<File>(fileName.c_str(), header);
+    } catch (const std::exception &e) {
+        std::cerr << "error opening image file " << fileName << ": " << e.what() << std::endl;
+    }
+}
 
-        Imf_3_2::Header header(displayWindow, dataWindow);
+size_t EXRTileSink::band_height() const {
+    return static_cast<size_t>(tileSize);
+}
+
+void EXRTileSink::write(const size_t first_row, const size_t rows, const float *data) {
+    if (!file) return;
+
+    // the slices address the band as if it were placed in the whole image
+    const size_t xStride = 3 * sizeof(float);
+    const size_t yStride = xStride * width;
+    char *origin = reinterpret_cast<char *>(const_cast<float *>(data)) - first_row * yStride;
+
+    Imf::FrameBuffer frameBuffer;
+    frameBuffer.insert("R", Imf::Slice(Imf::FLOAT, origin, xStride, yStride));
+    frameBuffer.insert("G", Imf::Slice(Imf::FLOAT, origin + sizeof(float), xStride, yStride));
+    frameBuffer.insert("B", Imf::Slice(Imf::FLOAT, origin + 2 * sizeof(float), xStride, yStride));
 
-        header.insert("render_time", Imf_3_2::IntAttribute(render_time));
+    const int tileRow = static_cast<int>(first_row) / tileSize;
 
-        Imf::RgbaOutputFile file (fileName.c_str(), header);
-        file.setFrameBuffer (&pixels[0][0], 1, width);
-        file.writePixels (height);
+    std::lock_guard lock(mutex);
+    try {
+        file->output.setFrameBuffer(frameBuffer);
+        file->output.writeTiles(0, file->output.numXTiles() - 1, tileRow, tileRow);
     } catch (const std::exception &e) {
-        std::cerr << "error writing image file " <<  fileName << std::endl;
+        std::cerr << "error writing image file " << fileName << ": " << e.what() << std::endl;
     }
 }
+
+void EXRTileSink::close() {
+    std::lock_guard lock(mutex);
+    file.reset();
+}
+
+// ============================================================================
+// RawTileSink
+// ============================================================================
+
+RawTileSink::RawTileSink(std::filesystem::path path, const size_t bandHeight):
+    path(std::move(path)), bandHeight(std::max<size_t>(1, bandHeight)) {}
+
+void RawTileSink::open(const size_t width, const size_t height) {
+    this->width = width;
+
+    out.open(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "error opening image file " << path << std::endl;
+        return;
+    }
+
+    char header[headerSize] = {'Y', 'A', 'P', 'T', 'R', 'A', 'W', '\0'};
+    for (int i = 0; i < 8; ++i) {
+        header[8 + i] = static_cast<char>((static_cast<uint64_t>(width) >> (8 * i)) & 0xFF);
+        header[16 + i] = static_cast<char>((static_cast<uint64_t>(height) >> (8 * i)) & 0xFF);
+    }
+    out.write(header, headerSize);
+    out.close();
+
+    // the file is sized once, the bands are then written in place
+    std::filesystem::resize_file(path, headerSize + 3 * sizeof(float) * width * height);
+    out.open(path, std::ios::binary | std::ios::in | std::ios::out);
+}
+
+void RawTileSink::write(const size_t first_row, const size_t rows, const float *data) {
+    std::lock_guard lock(mutex);
+    out.seekp(static_cast<std::streamoff>(headerSize + 3 * sizeof(float) * width * first_row));
+    out.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(3 * sizeof(float) * width * rows));
+}
+
+void RawTileSink::close() {
+    std::lock_guard lock(mutex);
+    out.close();
+}
@@ -0,0 +1,152 @@
+/*
+ * This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
+ * Copyright (c) 2025 PrISE-3D.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * --- ADDITIONAL PERMISSION UNDER GNU GPL VERSION 3 SECTION 7 ---
+ *
+ * If you modify this Program, or any covered work, by linking or
+ * combining it with the Intel Math Kernel Library (MKL) (or a modified
+ * version of that library), containing parts covered by the terms of
+ * the Intel Simplified Software License, the licensors of this
+ * Program grant you additional permission to convey the resulting work.
+ */
+
+#include "light_bounds.h"
+#include <algorithm>
+
+namespace {
+    double safe_sqrt(const double x) { return sqrt(std::max(0., x)); }
+
+    double safe_acos(const double x) { return acos(std::clamp(x, -1., 1.)); }
+
+    // cos(max(0, a - b)) from the sines and cosines of a and b
+    double cos_sub_clamped(const double sin_a, const double cos_a, const double sin_b, const double cos_b) {
+        if (cos_a > cos_b) return 1;
+        return cos_a * cos_b + sin_a * sin_b;
+    }
+
+    // sin(max(0, a - b)) from the sines and cosines of a and b
+    double sin_sub_clamped(const double sin_a, const double cos_a, const double sin_b, const double cos_b) {
+        if (cos_a > cos_b) return 0;
+        return sin_a * cos_b - cos_a * sin_b;
+    }
+
+    // rotates v by angle (radians) around the unit vector axis (Rodrigues' formula)
+    Vec3 rotate(const Vec3 &v, const Vec3 &axis, const double angle) {
+        const double c = cos(angle);
+        const double s = sin(angle);
+        return c * v + s * cross(axis, v) + (1 - c) * dot(axis, v) * axis;
+    }
+
+    // cosine of the half angle of the cone of directions from p to the box, -1 if p is inside the box
+    double cos_subtended(const AABB &bounds, const Point3 &p) {
+        const Point3 min(bounds.x.min, bounds.y.min, bounds.z.min);
+        const Point3 max(bounds.x.max, bounds.y.max, bounds.z.max);
+        const Point3 center = (min + max) / 2;
+        const double radius2 = (max - center).length2();
+        const double distance2 = (p - center).length2();
+
+        if (distance2 < radius2) return -1;
+
+        const double sin2_theta_max = radius2 / distance2;
+        return safe_sqrt(1 - sin2_theta_max);
+    }
+}
+
+// ============================================================================
+// LightBounds
+// ============================================================================
+
+LightBounds::LightBounds(const AABB &bounds, const double phi)
+    : bounds(bounds), w(0, 0, 1), phi(phi), cos_theta_o(-1), cos_theta_e(0), two_sided(false) {}
+
+LightBounds::LightBounds(const AABB &bounds, const Vec3 &w, const double phi, const double cos_theta_o,
+                         const double cos_theta_e, const bool two_sided)
+    : bounds(bounds), w(unit_vector(w)), phi(phi), cos_theta_o(cos_theta_o), cos_theta_e(cos_theta_e),
+      two_sided(two_sided) {}
+
+Point3 LightBounds::centroid() const {
+    return {
+        (bounds.x.min + bounds.x.max) / 2,
+        (bounds.y.min + bounds.y.max) / 2,
+        (bounds.z.min + bounds.z.max) / 2
+    };
+}
+
+double LightBounds::importance(const Point3 &p) const {
+    const Point3 pc = centroid();
+    const Vec3 diagonal(bounds.x.size(), bounds.y.size(), bounds.z.size());
+
+    // clamp the distance to avoid unbounded importance for points close to or inside the cluster
+    const double d2 = std::max((p - pc).length2(), diagonal.length() / 2);
+
+    // angle between the cone axis and the direction to p
+    const Vec3 wi = unit_vector(p - pc);
+    double cos_theta_w = dot(w, wi);
+    if (two_sided) cos_theta_w = fabs(cos_theta_w);
+    const double sin_theta_w = safe_sqrt(1 - cos_theta_w * cos_theta_w);
+
+    // bound the angle between the emitting normals and the direction to p, accounting for the extent of the box
+    const double cos_theta_b = cos_subtended(bounds, p);
+    const double sin_theta_b = safe_sqrt(1 - cos_theta_b * cos_theta_b);
+    const double sin_theta_o = safe_sqrt(1 - cos_theta_o * cos_theta_o);
+
+    const double cos_theta_x = cos_sub_clamped(sin_theta_w, cos_theta_w, sin_theta_o, cos_theta_o);
+    const double sin_theta_x = sin_sub_clamped(sin_theta_w, cos_theta_w, sin_theta_o, cos_theta_o);
+    const double cos_theta_p = cos_sub_clamped(sin_theta_x, cos_theta_x, sin_theta_b, cos_theta_b);
+
+    if (cos_theta_p <= cos_theta_e) return 0;
+
+    return phi * cos_theta_p / d2;
+}
+
+LightBounds LightBounds::merge(const LightBounds &a, const LightBounds &b) {
+    if (a.phi <= 0) return b;
+    if (b.phi <= 0) return a;
+
+    LightBounds result;
+    result.bounds = AABB(a.bounds, b.bounds);
+    result.phi = a.phi + b.phi;
+    result.cos_theta_e = std::min(a.cos_theta_e, b.cos_theta_e);
+    result.two_sided = a.two_sided || b.two_sided;
+
+    // smallest cone containing both normal cones
+    const double theta_a = safe_acos(a.cos_theta_o);
+    const double theta_b = safe_acos(b.cos_theta_o);
+    const double theta_d = safe_acos(dot(a.w, b.w));
+
+    if (std::min(theta_d + theta_b, pi) <= theta_a) {
+        result.w = a.w;
+        result.cos_theta_o = a.cos_theta_o;
+        return result;
+    }
+    if (std::min(theta_d + theta_a, pi) <= theta_b) {
+        result.w = b.w;
+        result.cos_theta_o = b.cos_theta_o;
+        return result;
+    }
+
+    const double theta_o = (theta_a + theta_d + theta_b) / 2;
+    const Vec3 wr = cross(a.w, b.w);
+
+    if (theta_o >= pi || wr.length2() == 0) {
+        result.w = a.w;
+        result.cos_theta_o = -1;
+        return result;
+    }
+
+    result.w = unit_vector(rotate(a.w, unit_vector(wr), theta_o - theta_a));
+    result.cos_theta_o = cos(theta_o);
+    return result;
+}
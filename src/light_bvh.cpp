@@ -0,0 +1,134 @@
+/*
+ * This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
+ * Copyright (c) 2025 PrISE-3D.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * --- ADDITIONAL PERMISSION UNDER GNU GPL VERSION 3 SECTION 7 ---
+ *
+ * If you modify this Program, or any covered work, by linking or
+ * combining it with the Intel Math Kernel Library (MKL) (or a modified
+ * version of that library), containing parts covered by the terms of
+ * the Intel Simplified Software License, the licensors of this
+ * Program grant you additional permission to convey the resulting work.
+ */
+
+#include "light_bvh.h"
+#include <algorithm>
+
+// ============================================================================
+// LightBVH
+// ============================================================================
+
+LightBVH::LightBVH(const shared_ptr<HittableList> &lights) : LightSampler(lights) {
+    if (this->lights.empty()) return;
+
+    // non emissive lights (portals) are given a power so that they are still sampled
+    const std::vector<double> weights = power_weights();
+
+    std::vector<std::pair<std::size_t, LightBounds>> items;
+    items.reserve(this->lights.size());
+    for (std::size_t i = 0 ; i < this->lights.size() ; ++i) {
+        LightBounds bounds = this->lights[i]->light_bounds();
+        bounds.phi = weights[i];
+        items.emplace_back(i, bounds);
+    }
+
+    trails = std::vector<uint64_t>(this->lights.size(), 0);
+    nodes.reserve(2 * items.size() - 1);
+    build(items, 0, items.size(), 0, 0);
+}
+
+std::size_t LightBVH::build(std::vector<std::pair<std::size_t, LightBounds>> &items, const std::size_t start,
+                            const std::size_t end, const uint64_t trail, const int depth) {
+    const std::size_t node = nodes.size();
+    nodes.emplace_back();
+
+    if (end - start == 1) {
+        nodes[node].bounds = items[start].second;
+        nodes[node].index = items[start].first;
+        nodes[node].leaf = true;
+        trails[items[start].first] = trail;
+        return node;
+    }
+
+    // median split of the light centroids along their longest axis
+    AABB centroids;
+    for (std::size_t i = start ; i < end ; ++i) {
+        const Point3 c = items[i].second.centroid();
+        centroids = AABB(centroids, AABB(c, c));
+    }
+    const int axis = centroids.longest_axis();
+
+    const std::size_t mid = start + (end - start) / 2;
+    std::nth_element(items.begin() + static_cast<long>(start), items.begin() + static_cast<long>(mid),
+                     items.begin() + static_cast<long>(end),
+                     [axis](const auto &a, const auto &b) {
+                         return a.second.centroid()[axis] < b.second.centroid()[axis];
+                     });
+
+    // paths deeper than 64 cannot be stored in a trail, this requires far more than 2^64 lights with median splits
+    const std::size_t left = build(items, start, mid, trail, depth + 1);
+    const std::size_t right = build(items, mid, end, trail | (uint64_t(1) << depth), depth + 1);
+
+    nodes[node].bounds = LightBounds::merge(nodes[left].bounds, nodes[right].bounds);
+    nodes[node].index = right;
+    return node;
+}
+
+double LightBVH::left_probability(const std::size_t node, const Point3 &origin) const {
+    const LightBounds &left = nodes[node + 1].bounds;
+    const LightBounds &right = nodes[nodes[node].index].bounds;
+
+    const double importance_left = left.importance(origin);
+    const double importance_right = right.importance(origin);
+
+    if (importance_left + importance_right > 0)
+        return importance_left / (importance_left + importance_right);
+
+    // neither child can reach the point: fall back to the power so that every light keeps a non null probability
+    if (left.phi + right.phi > 0)
+        return left.phi / (left.phi + right.phi);
+
+    return .5;
+}
+
+std::size_t LightBVH::pick(const Point3 &origin) const {
+    std::size_t node = 0;
+
+    while (!nodes[node].leaf) {
+        const double p = left_probability(node, origin);
+        node = random_double() < p ? node + 1 : nodes[node].index;
+    }
+
+    return nodes[node].index;
+}
+
+double LightBVH::probability(const std::size_t index, const Point3 &origin) const {
+    double probability = 1;
+    std::size_t node = 0;
+    uint64_t trail = trails[index];
+
+    while (!nodes[node].leaf) {
+        const double p = left_probability(node, origin);
+        if (trail & 1) {
+            probability *= 1 - p;
+            node = nodes[node].index;
+        } else {
+            probability *= p;
+            node = node + 1;
+        }
+        trail >>= 1;
+    }
+
+    return probability;
+}
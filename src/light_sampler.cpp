@@ -0,0 +1,202 @@
+/*
+ * This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
+ * Copyright (c) 2025 PrISE-3D.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * --- ADDITIONAL PERMISSION UNDER GNU GPL VERSION 3 SECTION 7 ---
+ *
+ * If you modify this Program, or any covered work, by linking or
+ * combining it with the Intel Math Kernel Library (MKL) (or a modified
+ * version of that library), containing parts covered by the terms of
+ * the Intel Simplified Software License, the licensors of this
+ * Program grant you additional permission to convey the resulting work.
+ */
+
+#include "light_sampler.h"
+#include <algorithm>
+
+// ============================================================================
+// AliasTable
+// ============================================================================
+
+AliasTable::AliasTable(const std::vector<double> &weights) {
+    const std::size_t n = weights.size();
+    probabilities = std::vector<double>(n);
+    thresholds = std::vector<double>(n);
+    aliases = std::vector<std::size_t>(n);
+
+    if (n == 0) return;
+
+    double sum = 0.;
+    for (const double w : weights) sum += std::max(w, 0.);
+
+    for (std::size_t i = 0 ; i < n ; ++i) {
+        probabilities[i] = sum > 0 ? std::max(weights[i], 0.) / sum : 1. / static_cast<double>(n);
+    }
+
+    // Vose's construction: bins are filled up to 1 / n by borrowing probability mass from the larger bins
+    std::vector<double> scaled(n);
+    std::vector<std::size_t> small;
+    std::vector<std::size_t> large;
+
+    for (std::size_t i = 0 ; i < n ; ++i) {
+        scaled[i] = probabilities[i] * static_cast<double>(n);
+        if (scaled[i] < 1.) small.push_back(i);
+        else large.push_back(i);
+    }
+
+    while (!small.empty() && !large.empty()) {
+        const std::size_t s = small.back();
+        small.pop_back();
+        const std::size_t l = large.back();
+        large.pop_back();
+
+        thresholds[s] = scaled[s];
+        aliases[s] = l;
+
+        scaled[l] = scaled[l] + scaled[s] - 1.;
+        if (scaled[l] < 1.) small.push_back(l);
+        else large.push_back(l);
+    }
+
+    // the remaining bins are full (up to rounding errors)
+    for (const std::size_t i : large) {
+        thresholds[i] = 1.;
+        aliases[i] = i;
+    }
+    for (const std::size_t i : small) {
+        thresholds[i] = 1.;
+        aliases[i] = i;
+    }
+}
+
+std::size_t AliasTable::sample(const double u) const {
+    const std::size_t n = thresholds.size();
+    const double scaled = u * static_cast<double>(n);
+    const std::size_t index = std::min(static_cast<std::size_t>(scaled), n - 1);
+    const double remainder = scaled - static_cast<double>(index);
+    return remainder < thresholds[index] ? index : aliases[index];
+}
+
+// ============================================================================
+// LightSampler
+// ============================================================================
+
+LightSampler::LightSampler(const shared_ptr<HittableList> &lights) : lights(lights->objects) {
+    bbox = lights->bounding_box();
+
+    for (std::size_t i = 0 ; i < this->lights.size() ; ++i) {
+        this->lights[i]->set_light_id(static_cast<int>(i));
+    }
+}
+
+bool LightSampler::hit(const Ray &r, const Interval ray_t, HitRecord &rec) const {
+    bool hit_anything = false;
+    auto closest_so_far = ray_t.max;
+
+    for (const auto &light: lights) {
+        if (light->hit(r, Interval(ray_t.min, closest_so_far), rec)) {
+            hit_anything = true;
+            closest_so_far = rec.t;
+        }
+    }
+
+    return hit_anything;
+}
+
+double LightSampler::pdfValue(const Point3 &origin, const Vec3 &direction) const {
+    auto sum = 0.0;
+
+    for (std::size_t i = 0 ; i < lights.size() ; ++i) {
+        const double p = probability(i, origin);
+        if (p > 0) sum += p * lights[i]->pdfValue(origin, direction);
+    }
+
+    return sum;
+}
+
+double LightSampler::pdfValue(const Point3 &origin, const Vec3 &direction, const HitRecord &rec) const {
+    if (rec.light_id < 0 || static_cast<std::size_t>(rec.light_id) >= lights.size())
+        return 0;
+
+    const auto index = static_cast<std::size_t>(rec.light_id);
+    return probability(index, origin) * lights[index]->pdfValue(origin, direction, rec);
+}
+
+Vec3 LightSampler::random(const Point3 &origin) const {
+    if (lights.empty())
+        return {1, 0, 0};
+
+    return lights[pick(origin)]->random(origin);
+}
+
+double LightSampler::power() const {
+    auto sum = 0.0;
+
+    for (const auto &light: lights)
+        sum += light->power();
+
+    return sum;
+}
+
+std::vector<double> LightSampler::power_weights() const {
+    std::vector<double> weights(lights.size());
+    double emissive_power = 0.;
+    std::size_t emissive_count = 0;
+
+    for (std::size_t i = 0 ; i < lights.size() ; ++i) {
+        weights[i] = lights[i]->power();
+        if (weights[i] > 0) {
+            emissive_power += weights[i];
+            ++emissive_count;
+        }
+    }
+
+    const double average = emissive_count > 0 ? emissive_power / static_cast<double>(emissive_count) : 1.;
+
+    for (auto &weight : weights) {
+        if (weight <= 0) weight = average;
+    }
+
+    return weights;
+}
+
+// ============================================================================
+// UniformLightSampler
+// ============================================================================
+
+UniformLightSampler::UniformLightSampler(const shared_ptr<HittableList> &lights) : LightSampler(lights) {}
+
+std::size_t UniformLightSampler::pick(const Point3 &origin) const {
+    const auto int_size = static_cast<int>(lights.size());
+    return static_cast<std::size_t>(random_int(0, int_size - 1));
+}
+
+double UniformLightSampler::probability(std::size_t index, const Point3 &origin) const {
+    return 1. / static_cast<double>(lights.size());
+}
+
+// ============================================================================
+// PowerLightSampler
+// ============================================================================
+
+PowerLightSampler::PowerLightSampler(const shared_ptr<HittableList> &lights)
+    : LightSampler(lights), table(power_weights()) {}
+
+std::size_t PowerLightSampler::pick(const Point3 &origin) const {
+    return table.sample(random_double());
+}
+
+double PowerLightSampler::probability(const std::size_t index, const Point3 &origin) const {
+    return table.probability(index);
+}
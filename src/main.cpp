@@ -32,7 +32,7 @@ int main(const int argc, char* argv[]) {
     if (!parser.parseScene(argc, argv, scene)) return 0;
 
     parser.startTimer();
-    scene.camera->render(*scene.content, *scene.lights);
+    scene.camera->render(*scene.content, *scene.lightSampler);
     parser.stopTimer();
 
     parser.exportImage(argc, argv, scene);
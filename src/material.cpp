@@ -39,6 +39,10 @@ double Lambertian::scattering_pdf(const Ray &r_in, const HitRecord &rec, const R
     return cos_theta < 0 ? 0 : cos_theta / pi;
 }
 
+Color Lambertian::albedo_at(const HitRecord &rec) const {
+    return tex->value(rec.u, rec.v, rec.p);
+}
+
 bool Metal::scatter(const Ray &r_in, const HitRecord &rec, ScatterRecord &scatterRecord) const {
     Vec3 reflected = reflect(r_in.direction(), rec.normal);
     reflected = unit_vector(reflected) + (fuzz * random_unit_vector());
@@ -89,4 +93,8 @@ bool Isotropic::scatter(const Ray &r_in, const HitRecord &rec, ScatterRecord &sc
 
 double Isotropic::scattering_pdf(const Ray &r_in, const HitRecord &rec, const Ray &scattered) const {
     return 1 / (4 * pi);
-}
\ No newline at end of file
+}
+
+Color Isotropic::albedo_at(const HitRecord &rec) const {
+    return tex->value(rec.u, rec.v, rec.p);
+}
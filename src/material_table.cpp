@@ -1,5 +1,5 @@
 /*
-* This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
+ * This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
  * Copyright (c) 2025 PrISE-3D.
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -22,25 +22,23 @@
  * Program grant you additional permission to convey the resulting work.
  */
 
-#include "Vec3.h"
-#include "ray.h"
+#include "material_table.h"
+#include <unordered_map>
 
-Ray::Ray() = default;
+std::vector<shared_ptr<Material>> MaterialTable::materials;
 
-Ray::Ray(const Point3 &o, const Vec3 &dir) : orig(o), dir(dir) {}
-
-[[nodiscard]] Point3 Ray::at(double t) const {
-    return orig + t * dir;
+namespace {
+    std::unordered_map<const Material *, uint32_t> indices;
 }
 
-[[nodiscard]] const Point3 &Ray::origin() const {
-    return orig;
-}
+uint32_t MaterialTable::add(const shared_ptr<Material> &material) {
+    if (!material) return none;
 
-[[nodiscard]] const Vec3 &Ray::direction() const {
-    return dir;
-}
+    if (const auto found = indices.find(material.get()); found != indices.end())
+        return found->second;
 
-Ray Ray::shoot(Point3 &from, Point3 &aiming) {
-    return {from, aiming - from};
-}
\ No newline at end of file
+    const auto id = static_cast<uint32_t>(materials.size());
+    materials.push_back(material);
+    indices[material.get()] = id;
+    return id;
+}
@@ -0,0 +1,217 @@
+/*
+ * This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
+ * Copyright (c) 2025 PrISE-3D.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * --- ADDITIONAL PERMISSION UNDER GNU GPL VERSION 3 SECTION 7 ---
+ *
+ * If you modify this Program, or any covered work, by linking or
+ * combining it with the Intel Math Kernel Library (MKL) (or a modified
+ * version of that library), containing parts covered by the terms of
+ * the Intel Simplified Software License, the licensors of this
+ * Program grant you additional permission to convey the resulting work.
+ */
+
+#include "native_function.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <fstream>
+#include <functional>
+#include <pwd.h>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    const std::string entry_point = "yapt_function_batch";
+
+    // source of the shared object evaluating a batch of points
+    std::string translation_unit(const std::string &expression) {
+        std::ostringstream out;
+        out << "#include <cmath>\n"
+            << "#include <cstddef>\n\n"
+            << "static inline double yapt_frac(const double v) { return v - std::trunc(v); }\n"
+            << "static inline double yapt_compare(const bool b) { return b ? 1. : 0.; }\n"
+            << "static inline double yapt_power(const double a, const double e) {\n"
+            << "    if (e == 2.) return a * a;\n"
+            << "    if (e == 3.) return a * (a * a);\n"
+            << "    if (e == .5) return std::sqrt(a);\n"
+            << "    return std::pow(a, e);\n"
+            << "}\n\n"
+            << "extern \"C\" void " << entry_point
+            << "(const double *xs, const double *ys, double *out, const std::size_t n) {\n"
+            << "    for (std::size_t i = 0; i < n; ++i) {\n"
+            << "        const double x = xs[i];\n"
+            << "        const double y = ys[i];\n"
+            << "        out[i] = " << expression << ";\n"
+            << "    }\n"
+            << "}\n";
+        return out.str();
+    }
+
+    // standard output of a shell command, empty when it cannot run
+    std::string command_output(const std::string &command) {
+        std::string output;
+        FILE *pipe = popen((command + " 2>/dev/null").c_str(), "r");
+        if (!pipe) return output;
+
+        char buffer[256];
+        while (const std::size_t read = std::fread(buffer, 1, sizeof(buffer), pipe))
+            output.append(buffer, read);
+        pclose(pipe);
+        return output;
+    }
+
+    // the model and feature flags of the host CPU, read from /proc/cpuinfo
+    std::string cpu_identity() {
+        std::ifstream cpuinfo("/proc/cpuinfo");
+        std::string line, model, features;
+
+        while (std::getline(cpuinfo, line) && (model.empty() || features.empty())) {
+            if (model.empty() && line.rfind("model name", 0) == 0) model = line;
+            else if (features.empty() && (line.rfind("flags", 0) == 0 || line.rfind("Features", 0) == 0))
+                features = line;
+        }
+        return model + "\n" + features;
+    }
+
+    // what -march=native targets on this host, so that a cache shared between machines never loads an object built
+    // for instructions the CPU lacks: the options the compiler resolves it to, else the CPU itself
+    std::string native_target(const std::string &compiler) {
+        const std::string target = command_output(compiler + " -march=native -Q --help=target");
+        return target.empty() ? cpu_identity() : target;
+    }
+
+    // a directory or regular file owned by the effective user that nobody else may write to
+    bool is_private(const std::filesystem::path &path, const bool directory) {
+        struct stat status{};
+        if (lstat(path.c_str(), &status) != 0) return false;
+        if (directory ? !S_ISDIR(status.st_mode) : !S_ISREG(status.st_mode)) return false;
+        return status.st_uid == geteuid() && (status.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+    }
+}
+
+std::filesystem::path NativeFunction::cache_directory() {
+    if (const char *directory = std::getenv("YAPT_JIT_CACHE"); directory && *directory)
+        return directory;
+    if (const char *cache = std::getenv("XDG_CACHE_HOME"); cache && *cache)
+        return std::filesystem::path(cache) / "yapt-jit";
+
+    const char *home = std::getenv("HOME");
+    if (!home || !*home) {
+        const passwd *user = getpwuid(geteuid());
+        if (!user) return {};
+        home = user->pw_dir;
+    }
+    return std::filesystem::path(home) / ".cache" / "yapt-jit";
+}
+
+shared_ptr<NativeFunction> NativeFunction::compile(const FunctionProgram &program) {
+    const std::string source = translation_unit(program.to_cpp());
+    const char *compiler = std::getenv("CXX");
+    const std::string cc = compiler ? compiler : "c++";
+    // no contraction to fused multiply-adds, so values match the bytecode and exprtk
+    const std::string flags = " -std=c++17 -O3 -march=native -ffp-contract=off -shared -fPIC";
+    const std::string build = cc + flags;
+    // a compiler upgrade or another host CPU does not reuse stale objects
+    const std::string key = build + "\n" + command_output(cc + " --version") + "\n" + native_target(cc) + "\n" + source;
+    const std::string name = std::to_string(std::hash<std::string>()(key));
+
+    // objects are loaded into the process, so only trust a cache nobody else can write to
+    const auto directory = cache_directory();
+    if (directory.empty()) {
+        std::cerr << "no directory for native functions" << std::endl;
+        return nullptr;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(directory.parent_path(), error);
+    if (mkdir(directory.c_str(), 0700) != 0 && errno != EEXIST) {
+        std::cerr << "cannot create " << directory << ": " << std::strerror(errno) << std::endl;
+        return nullptr;
+    }
+    if (!is_private(directory, true)) {
+        std::cerr << "refusing native functions: " << directory
+                  << " is not a directory owned by the current user and private to it" << std::endl;
+        return nullptr;
+    }
+
+    const auto library = directory / (name + ".so");
+
+    if (!std::filesystem::exists(library)) {
+        // built under unique names then renamed, so concurrent runs never load a partial object
+        std::string unique = (directory / (name + "-XXXXXX.cpp")).string();
+        const int descriptor = mkstemps(unique.data(), 4);
+        if (descriptor < 0) {
+            std::cerr << "cannot create native function source: " << std::strerror(errno) << std::endl;
+            return nullptr;
+        }
+        const std::filesystem::path cpp = unique;
+        auto partial = cpp;
+        partial.replace_extension(".so");
+
+        const bool written = write(descriptor, source.data(), source.size()) == static_cast<ssize_t>(source.size());
+        close(descriptor);
+        if (!written) {
+            std::cerr << "cannot write native function source" << std::endl;
+            std::filesystem::remove(cpp, error);
+            return nullptr;
+        }
+
+        const std::string command = build + " -o \"" + partial.string() + "\" \"" + cpp.string() + "\"";
+
+        std::cerr << "compiling native function: " << command << std::endl;
+        const int status = std::system(command.c_str());
+        std::filesystem::remove(cpp, error);
+
+        if (status != 0) {
+            std::cerr << "native function compilation failed" << std::endl;
+            std::filesystem::remove(partial, error);
+            return nullptr;
+        }
+
+        if (std::rename(partial.c_str(), library.c_str()) != 0) {
+            std::cerr << "cannot store native function: " << std::strerror(errno) << std::endl;
+            std::filesystem::remove(partial, error);
+            return nullptr;
+        }
+    }
+
+    if (!is_private(library, false)) {
+        std::cerr << "refusing native function: " << library
+                  << " is not a file owned by the current user and private to it" << std::endl;
+        return nullptr;
+    }
+
+    void *handle = dlopen(library.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        std::cerr << "cannot load native function: " << dlerror() << std::endl;
+        return nullptr;
+    }
+
+    const auto batch = reinterpret_cast<Batch>(dlsym(handle, entry_point.c_str()));
+    if (!batch) {
+        std::cerr << "cannot find native function: " << dlerror() << std::endl;
+        dlclose(handle);
+        return nullptr;
+    }
+
+    return shared_ptr<NativeFunction>(new NativeFunction(handle, batch));
+}
+
+NativeFunction::~NativeFunction() {
+    dlclose(handle);
+}
@@ -112,13 +112,13 @@ bool SimpleGuidingStrategy::grow(Path &path) {
 
     const HitRecord hitRecord = lastStep.hitRecord;
 
-    Color color_from_emission = hitRecord.mat->emitted(incomingRay, hitRecord, hitRecord.u, hitRecord.v, hitRecord.p);
+    Color color_from_emission = hitRecord.material()->emitted(incomingRay, hitRecord, hitRecord.u, hitRecord.v, hitRecord.p);
 
     ScatterRecord scatterRecord;
 
     // does the material scatter an outgoing ray?
     // captures a ScatterRecord to describe what happens at the surface of the material
-    const bool isScattering = hitRecord.mat->scatter(incomingRay, hitRecord, scatterRecord);
+    const bool isScattering = hitRecord.material()->scatter(incomingRay, hitRecord, scatterRecord);
 
     // registers the scatter record as the know scattering behaviour for the last step
     path.registerScatterRecord(scatterRecord);
@@ -147,6 +147,8 @@ bool SimpleGuidingStrategy::grow(Path &path) {
         return false;
     }
 
+    nextRecord.finalize(scatteredRay);
+
     path.append(PathStep(nextRecord));
     // all is well that ends well
     return true;
@@ -72,15 +72,11 @@ int main(int argc, char **argv) {
     Parser parser;
     Scene yaptScene;
     if (!parser.parseScene(argc, argv, yaptScene)) return 0;
-    yaptScene.camera->render(*yaptScene.content, *yaptScene.lights);
 
     QApplication app(argc, argv);
 
-    ImageData imageData = *yaptScene.camera->data();
-    QImage image = convertToQImage(imageData);
-
     QGraphicsScene scene;
-    auto *item = new QGraphicsPixmapItem(QPixmap::fromImage(image));
+    auto *item = new QGraphicsPixmapItem();
     scene.addItem(item);
 
     ZoomableImageView view(yaptScene, nullptr);
@@ -90,8 +86,17 @@ int main(int argc, char **argv) {
     view.setRenderHint(QPainter::Antialiasing);
     view.setWindowTitle("QtVor");
     view.resize(800, 800);
-    view.fitInView(scene.sceneRect(), Qt::KeepAspectRatio);
+
+    // the image fills in while rendering, the window staying responsive
+    ProgressiveRender render(parser, yaptScene, item);
+    render.onStatus = [&view](const QString &status) { view.setWindowTitle(status); };
+    view.setProgressiveRender(&render);
+    render.start();
+
+    view.fitInView(item->boundingRect(), Qt::KeepAspectRatio);
     view.show();
 
-    return app.exec();
-}
\ No newline at end of file
+    const int result = app.exec();
+    render.cancel();
+    return result;
+}
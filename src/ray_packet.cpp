@@ -0,0 +1,154 @@
+/*
+ * This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
+ * Copyright (c) 2025 PrISE-3D.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * --- ADDITIONAL PERMISSION UNDER GNU GPL VERSION 3 SECTION 7 ---
+ *
+ * If you modify this Program, or any covered work, by linking or
+ * combining it with the Intel Math Kernel Library (MKL) (or a modified
+ * version of that library), containing parts covered by the terms of
+ * the Intel Simplified Software License, the licensors of this
+ * Program grant you additional permission to convey the resulting work.
+ */
+
+#include "ray_packet.h"
+#include <algorithm>
+
+namespace {
+    // product of two intervals
+    Interval product(const double a_min, const double a_max, const double b_min, const double b_max) {
+        const double p0 = a_min * b_min;
+        const double p1 = a_min * b_max;
+        const double p2 = a_max * b_min;
+        const double p3 = a_max * b_max;
+        return {std::min({p0, p1, p2, p3}), std::max({p0, p1, p2, p3})};
+    }
+}
+
+// ============================================================================
+// Hittable
+// ============================================================================
+
+uint32_t Hittable::hit_packet(RayPacket &packet, const Interval ray_t) const {
+    uint32_t hits = 0;
+
+    for (std::size_t i = 0; i < packet.size; ++i) {
+        if (!(packet.active & (1u << i)))
+            continue;
+
+        if (hit(packet.rays[i], Interval(ray_t.min, std::min(ray_t.max, packet.t_max[i])), packet.records[i])) {
+            packet.t_max[i] = packet.records[i].t;
+            hits |= 1u << i;
+        }
+    }
+
+    if (hits)
+        packet.update_farthest();
+
+    return hits;
+}
+
+// ============================================================================
+// RayPacket
+// ============================================================================
+
+void RayPacket::clear() {
+    size = 0;
+    active = 0;
+}
+
+void RayPacket::add(const Ray &r) {
+    rays[size] = r;
+    records[size] = HitRecord();
+    t_max[size] = infinity;
+    active |= 1u << size;
+    ++size;
+}
+
+void RayPacket::update_farthest() {
+    farthest = -infinity;
+    for (std::size_t i = 0; i < size; ++i)
+        if (active & (1u << i))
+            farthest = std::max(farthest, t_max[i]);
+}
+
+void RayPacket::prepare() {
+    update_farthest();
+
+    for (int axis = 0; axis < 3; ++axis) {
+        double origin_min = infinity, origin_max = -infinity;
+        double inverse_min = infinity, inverse_max = -infinity;
+        bool positive = true, negative = true;
+        double sum = 0;
+
+        for (std::size_t i = 0; i < size; ++i) {
+            const double o = rays[i].origin()[axis];
+            const double d = rays[i].direction()[axis];
+            origin_min = std::min(origin_min, o);
+            origin_max = std::max(origin_max, o);
+            positive = positive && d > 0;
+            negative = negative && d < 0;
+            sum += d;
+            if (d != 0) {
+                inverse_min = std::min(inverse_min, 1 / d);
+                inverse_max = std::max(inverse_max, 1 / d);
+            }
+        }
+
+        origins[axis] = Interval(origin_min, origin_max);
+        inverse_directions[axis] = Interval(inverse_min, inverse_max);
+        same_sign[axis] = positive || negative;
+        backwards[axis] = sum < 0;
+    }
+}
+
+bool RayPacket::may_hit(const AABB &box, const Interval &ray_t) const {
+    return may_hit_slabs(box, ray_t);
+}
+
+bool RayPacket::may_hit(const CompactAABB &box, const Interval &ray_t) const {
+    return may_hit_slabs(box, ray_t);
+}
+
+template<typename Box>
+bool RayPacket::may_hit_slabs(const Box &box, const Interval &ray_t) const {
+    double t_enter = ray_t.min;
+    double t_exit = std::min(ray_t.max, farthest);
+
+    for (int axis = 0; axis < 3; ++axis) {
+        // axes along which the directions change sign cannot bound the slab distances
+        if (!same_sign[axis])
+            continue;
+
+        const Interval &slab = box.axis_interval(axis);
+        const Interval &o = origins[axis];
+        const Interval &inverse = inverse_directions[axis];
+
+        // ranges of the distances to both planes of the slab, over all rays of the packet
+        const Interval t0 = product(slab.min - o.max, slab.min - o.min, inverse.min, inverse.max);
+        const Interval t1 = product(slab.max - o.max, slab.max - o.min, inverse.min, inverse.max);
+
+        const bool positive = inverse.min > 0;
+        const Interval &near = positive ? t0 : t1;
+        const Interval &far = positive ? t1 : t0;
+
+        t_enter = std::max(t_enter, near.min);
+        t_exit = std::min(t_exit, far.max);
+
+        if (t_enter > t_exit)
+            return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,180 @@
+/*
+ * This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
+ * Copyright (c) 2025 PrISE-3D.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * --- ADDITIONAL PERMISSION UNDER GNU GPL VERSION 3 SECTION 7 ---
+ *
+ * If you modify this Program, or any covered work, by linking or
+ * combining it with the Intel Math Kernel Library (MKL) (or a modified
+ * version of that library), containing parts covered by the terms of
+ * the Intel Simplified Software License, the licensors of this
+ * Program grant you additional permission to convey the resulting work.
+ */
+
+#include "sample_dump.h"
+#include "aggregators.h"
+#include "torch_aggregator.h"
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <zlib.h>
+
+namespace {
+    constexpr uint32_t version = 1;
+    constexpr uint32_t compressed_flag = 1;
+    constexpr std::size_t max_pending = 256;
+
+    template<typename T>
+    void put(std::vector<char> &bytes, const T value) {
+        const auto *raw = reinterpret_cast<const char *>(&value);
+        bytes.insert(bytes.end(), raw, raw + sizeof(T));
+    }
+}
+
+SampleDump::SampleDump(const std::filesystem::path &path, const bool compress, const std::size_t chunkSamples):
+    out(path, std::ios::binary | std::ios::trunc), compress(compress), chunkSamples(std::max<std::size_t>(1, chunkSamples)) {
+    if (!out) {
+        std::cerr << "cannot open sample dump " << path << std::endl;
+        closing = true;
+        closed = true;
+        return;
+    }
+
+    std::vector<char> header;
+    header.insert(header.end(), {'Y', 'A', 'P', 'T', 'D', 'U', 'M', 'P'});
+    put(header, version);
+    put(header, compress ? compressed_flag : 0u);
+    out.write(header.data(), static_cast<std::streamsize>(header.size()));
+
+    writer = std::thread(&SampleDump::run, this);
+}
+
+SampleDump::~SampleDump() {
+    close();
+}
+
+void SampleDump::select(const std::size_t x0, const std::size_t y0, const std::size_t x1, const std::size_t y1) {
+    this->x0 = x0;
+    this->y0 = y0;
+    this->x1 = x1;
+    this->y1 = y1;
+}
+
+bool SampleDump::selected(const std::size_t row, const std::size_t column) const {
+    return column >= x0 && column < x1 && row >= y0 && row < y1;
+}
+
+void SampleDump::record(const std::size_t row, const std::size_t column, const SampleAggregator &aggregator) {
+    const auto count = static_cast<std::size_t>(aggregator.end() - aggregator.begin());
+    const std::pmr::vector<double> *weights = nullptr;
+    if (const auto *voronoi = dynamic_cast<const VoronoiAggregator *>(&aggregator))
+        weights = &voronoi->weights;
+    else if (const auto *learned = dynamic_cast<const TorchAggregator *>(&aggregator))
+        weights = &learned->weights;
+
+    Pending pending{{static_cast<uint32_t>(column), static_cast<uint32_t>(row), 0, static_cast<uint32_t>(count)}, {}};
+    pending.samples.reserve(count);
+
+    std::size_t i = 0;
+    for (const Sample &sample : aggregator) {
+        const Color c = i < aggregator.contributions.size() ? aggregator.contributions[i] : Color(0, 0, 0);
+        const double weight = weights && i < weights->size() ? (*weights)[i]
+                                                             : std::numeric_limits<double>::quiet_NaN();
+        pending.samples.push_back({sample.dx, sample.dy, static_cast<float>(c.x()), static_cast<float>(c.y()),
+                                   static_cast<float>(c.z()), static_cast<float>(weight)});
+        ++i;
+    }
+
+    std::unique_lock lock(mutex);
+    space.wait(lock, [this] { return queue.size() < max_pending || closing; });
+    if (closing) return;
+
+    queue.push_back(std::move(pending));
+    available.notify_one();
+}
+
+void SampleDump::close() {
+    {
+        std::lock_guard lock(mutex);
+        if (closed) return;
+        closing = true;
+        closed = true;
+    }
+
+    available.notify_all();
+    space.notify_all();
+    if (writer.joinable()) writer.join();
+    out.close();
+}
+
+void SampleDump::run() {
+    while (true) {
+        Pending pending;
+        {
+            std::unique_lock lock(mutex);
+            available.wait(lock, [this] { return !queue.empty() || closing; });
+            if (queue.empty()) break;
+
+            pending = std::move(queue.front());
+            queue.pop_front();
+        }
+        space.notify_one();
+
+        pending.pixel.first = static_cast<uint32_t>(samples.size());
+        pixels.push_back(pending.pixel);
+        samples.insert(samples.end(), pending.samples.begin(), pending.samples.end());
+
+        if (samples.size() >= chunkSamples) write_chunk();
+    }
+
+    write_chunk();
+}
+
+void SampleDump::write_chunk() {
+    if (pixels.empty()) return;
+
+    const std::size_t pixelBytes = pixels.size() * sizeof(PixelRecord);
+    const std::size_t sampleBytes = samples.size() * sizeof(SampleRecord);
+    const std::size_t rawSize = pixelBytes + sampleBytes;
+
+    std::vector<char> payload(rawSize);
+    std::memcpy(payload.data(), pixels.data(), pixelBytes);
+    std::memcpy(payload.data() + pixelBytes, samples.data(), sampleBytes);
+
+    if (compress) {
+        uLongf stored = compressBound(static_cast<uLong>(rawSize));
+        std::vector<char> deflated(stored);
+        if (compress2(reinterpret_cast<Bytef *>(deflated.data()), &stored,
+                      reinterpret_cast<const Bytef *>(payload.data()), static_cast<uLong>(rawSize),
+                      Z_BEST_SPEED) != Z_OK) {
+            std::cerr << "sample dump compression failed" << std::endl;
+            return;
+        }
+        deflated.resize(stored);
+        payload.swap(deflated);
+    }
+
+    std::vector<char> header;
+    header.insert(header.end(), {'C', 'H', 'N', 'K'});
+    put(header, static_cast<uint32_t>(pixels.size()));
+    put(header, static_cast<uint64_t>(samples.size()));
+    put(header, static_cast<uint64_t>(payload.size()));
+    put(header, static_cast<uint64_t>(rawSize));
+
+    out.write(header.data(), static_cast<std::streamsize>(header.size()));
+    out.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+
+    pixels.clear();
+    samples.clear();
+}
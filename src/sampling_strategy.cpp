@@ -27,24 +27,25 @@
 
 Color NEESamplingStrategy::compute_scattered_color(
     const SamplingContext& context,
-    const std::function<Color(const Ray&, int)>& ray_color_function
+    const std::function<Color(const Ray&, int, HitRecord&)>& ray_color_function
 ) const {
     Color colorFromScatter{0, 0, 0};
 
     // Next Event Estimation: Sample a point on the light
-    auto light_ptr = make_shared<HittablePDF>(context.lights, context.hit_record.p);
-    Ray light_ray(context.hit_record.p, light_ptr->generate());
-    double light_pdf = light_ptr->value(light_ray.direction());
-
-    if (light_pdf > 0) {
-        HitRecord light_rec;
-        // Check if the light is visible or oocluded
-        context.world.hit(light_ray, Interval(0.001, INFINITY), light_rec);
-        if (light_rec.t > 0.9999) {
-            Color light_emission = light_rec.mat->emitted(light_ray, light_rec,
-                                                          light_rec.u, light_rec.v, light_rec.p);
-            if (light_emission.length2() > 0) {
-                double scattering_pdf = context.hit_record.mat->scattering_pdf(
+    const Ray light_ray(context.hit_record.p, context.lights.random(context.hit_record.p));
+
+    HitRecord light_rec;
+    // Check if the light is visible or occluded
+    if (context.world.hit(light_ray, Interval(0.001, INFINITY), light_rec) && light_rec.t > 0.9999) {
+        light_rec.finalize(light_ray);
+        Color light_emission = light_rec.material()->emitted(light_ray, light_rec,
+                                                      light_rec.u, light_rec.v, light_rec.p);
+        if (light_emission.length2() > 0) {
+            // the hit record tells which light was reached, its pdf is evaluated without testing the other lights
+            double light_pdf = context.lights.pdfValue(light_ray.origin(), light_ray.direction(), light_rec);
+
+            if (light_pdf > 0) {
+                double scattering_pdf = context.hit_record.material()->scattering_pdf(
                     context.incoming_ray, context.hit_record, light_ray);
 
                 // POWER HEURISTIC (beta = 2)
@@ -63,12 +64,15 @@ Color NEESamplingStrategy::compute_scattered_color(
     const auto brdf_pdf = context.scatter_record.pdf_ptr->value(scattered.direction());
 
     if (brdf_pdf > 0) {
-        const double scatteringPdf = context.hit_record.mat->scattering_pdf(
+        const double scatteringPdf = context.hit_record.material()->scattering_pdf(
             context.incoming_ray, context.hit_record, scattered);
-        const Color sampleColor = ray_color_function(scattered, context.remaining_depth);
+        HitRecord scattered_rec;
+        const Color sampleColor = ray_color_function(scattered, context.remaining_depth, scattered_rec);
 
-        auto light_ptr_for_weight = make_shared<HittablePDF>(context.lights, context.hit_record.p);
-        double light_pdf_for_this_direction = light_ptr_for_weight->value(scattered.direction());
+        // the light pdf comes from the hit found while gathering the light: no new intersection
+        double light_pdf_for_this_direction = scattered_rec.light_id >= 0
+            ? context.lights.pdfValue(scattered.origin(), scattered.direction(), scattered_rec)
+            : 0;
 
         // POWER HEURISTIC (beta = 2)
         double light_pdf_2 = light_pdf_for_this_direction * light_pdf_for_this_direction;
@@ -84,19 +88,129 @@ Color NEESamplingStrategy::compute_scattered_color(
 
 Color MixtureSamplingStrategy::compute_scattered_color(
     const SamplingContext& context,
-    const std::function<Color(const Ray&, int)>& rayColorFunc
+    const std::function<Color(const Ray&, int, HitRecord&)>& rayColorFunc
 ) const {
     // Standard path tracing using a mixture of light and BRDF sampling
     const auto light_ptr = make_shared<HittablePDF>(context.lights, context.hit_record.p);
     const MixturePDF p(light_ptr, context.scatter_record.pdf_ptr);
 
     const auto scattered = Ray(context.hit_record.p, p.generate());
+    // a mixture needs the full density of the direction, summed over every light that covers it (even the occluded
+    // ones), so the hit of the scattered ray cannot replace the evaluation of each light
     const auto pdfValue = p.value(scattered.direction());
 
-    const double scatteringPdf = context.hit_record.mat->scattering_pdf(
+    const double scatteringPdf = context.hit_record.material()->scattering_pdf(
         context.incoming_ray, context.hit_record, scattered);
 
-    const Color sampleColor = rayColorFunc(scattered, context.remaining_depth);
+    HitRecord scattered_rec;
+    const Color sampleColor = rayColorFunc(scattered, context.remaining_depth, scattered_rec);
 
     return (context.scatter_record.attenuation * scatteringPdf * sampleColor) / pdfValue;
 }
+
+GuidedSamplingStrategy::GuidedSamplingStrategy(const bool nee, const std::size_t passes): nee(nee), passes(passes) {}
+
+void GuidedSamplingStrategy::begin_pass(const Hittable& world, std::size_t pass) {
+    if (!tree) tree = std::make_shared<SDTree>(world.bounding_box());
+    learning = true;
+}
+
+void GuidedSamplingStrategy::end_pass(const std::size_t pass) {
+    learning = false;
+    tree->refine(pass);
+}
+
+Color GuidedSamplingStrategy::compute_scattered_color(
+    const SamplingContext& context,
+    const std::function<Color(const Ray&, int, HitRecord&)>& ray_color_function
+) const {
+    const PDF &bsdf = *context.scatter_record.pdf_ptr;
+
+    // nothing learned yet, or around this point: the bsdf alone
+    const DTree *guide = tree ? &tree->guide(context.hit_record.p) : nullptr;
+    if (guide && guide->total() <= 0) guide = nullptr;
+    const double bsdf_fraction = guide ? bsdfFraction : 1.;
+
+    // the guide directions the bsdf discards under the surface are mirrored above it: early in the training, the
+    // guides spread over several surfaces would otherwise waste many paths
+    const Vec3 &normal = context.hit_record.normal;
+    const auto mirror = [&normal](const Vec3 &direction) { return direction - 2 * dot(direction, normal) * normal; };
+    const auto discarded = [&bsdf, &normal](const Vec3 &direction) {
+        return dot(direction, normal) < 0 && bsdf.value(direction) <= 0;
+    };
+
+    const auto guide_sample = [&]() {
+        const Vec3 direction = guide->sample();
+        return discarded(direction) ? mirror(direction) : direction;
+    };
+
+    const auto guide_pdf = [&](const Vec3 &direction) {
+        double pdf = discarded(direction) ? 0 : guide->pdf(direction);
+        if (const Vec3 mirrored = mirror(direction); discarded(mirrored)) pdf += guide->pdf(mirrored);
+        return pdf;
+    };
+
+    const auto direction_pdf = [&](const Vec3 &direction) {
+        double pdf = bsdf_fraction * bsdf.value(direction);
+        if (guide) pdf += (1 - bsdf_fraction) * guide_pdf(direction);
+        return pdf;
+    };
+
+    Color colorFromScatter{0, 0, 0};
+
+    if (nee) {
+        const Ray light_ray(context.hit_record.p, context.lights.random(context.hit_record.p));
+
+        HitRecord light_rec;
+        if (context.world.hit(light_ray, Interval(0.001, INFINITY), light_rec) && light_rec.t > 0.9999) {
+            light_rec.finalize(light_ray);
+            const Color light_emission = light_rec.material()->emitted(light_ray, light_rec,
+                                                                       light_rec.u, light_rec.v, light_rec.p);
+            const double light_pdf = light_emission.length2() > 0
+                ? context.lights.pdfValue(light_ray.origin(), light_ray.direction(), light_rec)
+                : 0;
+
+            if (light_pdf > 0) {
+                const double scattering_pdf = context.hit_record.material()->scattering_pdf(
+                    context.incoming_ray, context.hit_record, light_ray);
+                const double scattered_pdf = direction_pdf(light_ray.direction());
+
+                // POWER HEURISTIC (beta = 2)
+                const double weight_nee = light_pdf * light_pdf / (light_pdf * light_pdf + scattered_pdf * scattered_pdf);
+
+                colorFromScatter += weight_nee * context.scatter_record.attenuation *
+                                    scattering_pdf * light_emission / light_pdf;
+            }
+        }
+    }
+
+    const Vec3 direction = !guide || random_double() < bsdf_fraction ? bsdf.generate() : guide_sample();
+    const Ray scattered(context.hit_record.p, direction);
+    const double pdf = direction_pdf(direction);
+
+    if (pdf <= 0)
+        return colorFromScatter;
+
+    const double scatteringPdf = context.hit_record.material()->scattering_pdf(
+        context.incoming_ray, context.hit_record, scattered);
+    HitRecord scattered_rec;
+    const Color sampleColor = ray_color_function(scattered, context.remaining_depth, scattered_rec);
+
+    double weight = 1;
+    if (nee && scattered_rec.light_id >= 0) {
+        const double light_pdf = context.lights.pdfValue(scattered.origin(), scattered.direction(), scattered_rec);
+
+        // POWER HEURISTIC (beta = 2)
+        weight = pdf * pdf / (pdf * pdf + light_pdf * light_pdf);
+    }
+
+    colorFromScatter += weight * context.scatter_record.attenuation * scatteringPdf * sampleColor / pdf;
+
+    // the guide learns the incident radiance: each record estimates its integral over the cells of the direction
+    if (learning) {
+        const double radiance = luminance(sampleColor) / pdf;
+        if (std::isfinite(radiance)) tree->record(context.hit_record.p, direction, radiance);
+    }
+
+    return colorFromScatter;
+}
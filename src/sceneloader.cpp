@@ -146,6 +146,7 @@ shared_ptr<Hittable> YaptSceneLoader::load_hittable(std::ifstream &file) {
     std::regex boxexp(R"(box\s*=\s*(-?[0-9]*\.?[0-9]+)\s*,\s*(-?[0-9]*\.?[0-9]+)\s*,\s*(-?[0-9]*\.?[0-9]+)\s*-\s*(-?[0-9]*\.?[0-9]+)\s*,\s*(-?[0-9]*\.?[0-9]+)\s*,\s*(-?[0-9]*\.?[0-9]+)\s*-\s*([\w]+))");
     std::regex rotate(R"(rotate\s*=\s*([xyz])\s*,\s*(-?[0-9]*\.?[0-9]+)\s*-\s*([\w]+))");
     std::regex translateexp(R"(translate\s*=\s*(-?[0-9]*\.?[0-9]+)\s*,\s*(-?[0-9]*\.?[0-9]+)\s*,\s*(-?[0-9]*\.?[0-9]+)\s*-\s*([\w]+))");
+    std::regex samplingexp(R"(sampling\s*=\s*(area|solidangle)\s*-\s*([\w]+))");
     if (std::regex_match(line, matches, quad)) {
         Vec3 origin = vectorMatch(matches, 1);
         Vec3 u = vectorMatch(matches, 4);
@@ -180,6 +181,13 @@ shared_ptr<Hittable> YaptSceneLoader::load_hittable(std::ifstream &file) {
         Vec3 v = vectorMatch(matches, 1);
         std::string obj = matches[4];
         return make_shared<Translate>(hittables[obj], v);
+    } else
+    if (std::regex_match(line, matches, samplingexp)) {
+        std::string mode = matches[1];
+        std::string obj = matches[2];
+        std::clog << "found: Sampling " << mode << " - obj = " << obj << std::endl;
+        hittables[obj]->set_light_sampling(mode == "solidangle" ? LightSampling::SolidAngle : LightSampling::Area);
+        return hittables[obj];
     }
     return {};
 }
@@ -0,0 +1,300 @@
+/*
+ * This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
+ * Copyright (c) 2025 PrISE-3D.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * --- ADDITIONAL PERMISSION UNDER GNU GPL VERSION 3 SECTION 7 ---
+ *
+ * If you modify this Program, or any covered work, by linking or
+ * combining it with the Intel Math Kernel Library (MKL) (or a modified
+ * version of that library), containing parts covered by the terms of
+ * the Intel Simplified Software License, the licensors of this
+ * Program grant you additional permission to convey the resulting work.
+ */
+
+#include "sd_tree.h"
+#include <algorithm>
+
+namespace {
+    void atomic_add(std::atomic<double> &sum, const double value) {
+        double current = sum.load(std::memory_order_relaxed);
+        while (!sum.compare_exchange_weak(current, current + value, std::memory_order_relaxed)) {}
+    }
+
+    // cylindrical coordinates of a unit direction, in [0, 1]^2
+    void to_square(const Vec3 &direction, double &x, double &y) {
+        x = std::clamp((direction.z() + 1.) * .5, 0., 1.);
+        double phi = std::atan2(direction.y(), direction.x());
+        if (phi < 0) phi += 2 * pi;
+        y = std::clamp(phi / (2 * pi), 0., 1.);
+    }
+
+    Vec3 from_square(const double x, const double y) {
+        const double cos_theta = 2 * x - 1;
+        const double sin_theta = std::sqrt(std::max(0., 1 - cos_theta * cos_theta));
+        const double phi = 2 * pi * y;
+        return {sin_theta * std::cos(phi), sin_theta * std::sin(phi), cos_theta};
+    }
+}
+
+// ============================================================================
+// DTree
+// ============================================================================
+
+DTree::Node::Node(): children{0, 0, 0, 0} {
+    for (auto &sum : sums) sum.store(0., std::memory_order_relaxed);
+}
+
+DTree::Node::Node(const Node &other): children(other.children) {
+    for (int q = 0; q < 4; q++) sums[q].store(other.sums[q].load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+DTree::Node &DTree::Node::operator=(const Node &other) {
+    children = other.children;
+    for (int q = 0; q < 4; q++) sums[q].store(other.sums[q].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    return *this;
+}
+
+double DTree::Node::total() const {
+    double total = 0;
+    for (const auto &sum : sums) total += sum.load(std::memory_order_relaxed);
+    return total;
+}
+
+DTree::DTree(): nodes(1), records(0) {}
+
+DTree::DTree(const DTree &other): nodes(other.nodes), records(other.count()) {}
+
+DTree &DTree::operator=(const DTree &other) {
+    nodes = other.nodes;
+    records.store(other.count(), std::memory_order_relaxed);
+    return *this;
+}
+
+double DTree::total() const {
+    return nodes[0].total();
+}
+
+std::uint64_t DTree::count() const {
+    return records.load(std::memory_order_relaxed);
+}
+
+void DTree::record(const Vec3 &direction, const double value) {
+    records.fetch_add(1, std::memory_order_relaxed);
+    if (value <= 0) return;
+
+    double x, y;
+    to_square(unit_vector(direction), x, y);
+
+    std::uint32_t node = 0;
+    while (true) {
+        const int q = (x >= .5) + 2 * (y >= .5);
+        atomic_add(nodes[node].sums[q], value);
+
+        node = nodes[node].children[q];
+        if (node == 0) return;
+
+        x = 2 * x - (q & 1);
+        y = 2 * y - (q >> 1);
+    }
+}
+
+Vec3 DTree::sample() const {
+    if (total() <= 0)
+        return random_unit_vector();
+
+    double x = 0, y = 0, size = 1;
+    std::uint32_t node = 0;
+
+    while (true) {
+        const Node &n = nodes[node];
+        const double total = n.total();
+
+        // nothing recorded below: uniform in the cell
+        if (total <= 0) break;
+
+        double r = random_double() * total;
+        int q = 0;
+        for (; q < 3; q++) {
+            const double sum = n.sums[q].load(std::memory_order_relaxed);
+            if (r < sum) break;
+            r -= sum;
+        }
+        // rounding may land on an empty last quadrant
+        while (n.sums[q].load(std::memory_order_relaxed) <= 0) q--;
+
+        size *= .5;
+        x += size * (q & 1);
+        y += size * (q >> 1);
+
+        node = n.children[q];
+        if (node == 0) break;
+    }
+
+    return from_square(x + size * random_double(), y + size * random_double());
+}
+
+double DTree::pdf(const Vec3 &direction) const {
+    constexpr double uniform = 1. / (4 * pi);
+
+    if (total() <= 0)
+        return uniform;
+
+    double x, y;
+    to_square(unit_vector(direction), x, y);
+
+    // density relative to the uniform one, the mapping preserving areas
+    double density = 1;
+    std::uint32_t node = 0;
+
+    while (true) {
+        const Node &n = nodes[node];
+        const double total = n.total();
+        if (total <= 0) break;
+
+        const int q = (x >= .5) + 2 * (y >= .5);
+        density *= 4 * n.sums[q].load(std::memory_order_relaxed) / total;
+        if (density <= 0) return 0;
+
+        node = n.children[q];
+        if (node == 0) break;
+
+        x = 2 * x - (q & 1);
+        y = 2 * y - (q >> 1);
+    }
+
+    return density * uniform;
+}
+
+void DTree::refine(const DTree &from, const double fluxThreshold, const int maxDepth) {
+    struct Pending {
+        std::uint32_t node;
+        std::int64_t from;   // -1 below the leaves of the source: its energy is spread evenly
+        double energy;
+        int depth;
+    };
+
+    nodes.assign(1, Node());
+    records.store(0, std::memory_order_relaxed);
+
+    const double total = from.total();
+    if (total <= 0) return;
+
+    std::vector<Pending> stack{{0, 0, total, 1}};
+
+    while (!stack.empty()) {
+        const Pending pending = stack.back();
+        stack.pop_back();
+
+        for (int q = 0; q < 4; q++) {
+            double energy = pending.energy / 4;
+            std::int64_t child = -1;
+
+            if (pending.from >= 0) {
+                const Node &source = from.nodes[pending.from];
+                energy = source.sums[q].load(std::memory_order_relaxed);
+                if (source.children[q] != 0) child = source.children[q];
+            }
+
+            if (pending.depth >= maxDepth || energy / total <= fluxThreshold) continue;
+
+            const auto index = static_cast<std::uint32_t>(nodes.size());
+            nodes.emplace_back();
+            nodes[pending.node].children[q] = index;
+            stack.push_back({index, child, energy, pending.depth + 1});
+        }
+    }
+}
+
+// ============================================================================
+// SDTree
+// ============================================================================
+
+SDTree::SDTree(const AABB &bounds): nodes{{0, {0, 0}, 0}}, leaves(1) {
+    // a little margin so that points on the bounds fall inside
+    for (int axis = 0; axis < 3; axis++) {
+        const Interval &interval = bounds.axis_interval(axis);
+        double size = interval.size();
+        if (!(size > 0) || !std::isfinite(size)) size = 1;
+
+        origin[axis] = std::isfinite(interval.min) ? interval.min - .01 * size : -.5;
+        extent[axis] = 1.02 * size;
+    }
+}
+
+std::uint32_t SDTree::leaf_at(const Point3 &p) const {
+    double t[3];
+    for (int axis = 0; axis < 3; axis++)
+        t[axis] = std::clamp((p[axis] - origin[axis]) / extent[axis], 0., 1.);
+
+    std::uint32_t node = 0;
+    while (nodes[node].children[0] != 0) {
+        const int axis = nodes[node].axis;
+        const int side = t[axis] >= .5;
+        t[axis] = 2 * t[axis] - side;
+        node = nodes[node].children[side];
+    }
+
+    return nodes[node].leaf;
+}
+
+void SDTree::record(const Point3 &p, const Vec3 &direction, const double value) {
+    leaves[leaf_at(p)].building.record(direction, value);
+}
+
+const DTree &SDTree::guide(const Point3 &p) const {
+    return leaves[leaf_at(p)].sampling;
+}
+
+void SDTree::split(const std::uint32_t node, const double records, const double threshold, const int depth) {
+    if (depth >= maxSpatialDepth) return;
+
+    const auto first = static_cast<std::uint32_t>(nodes.size());
+    const int axis = (nodes[node].axis + 1) % 3;
+    const std::uint32_t leaf = nodes[node].leaf;
+
+    // the halves start with the distributions of the whole
+    Leaf copy = leaves[leaf];
+    nodes.push_back({axis, {0, 0}, leaf});
+    nodes.push_back({axis, {0, 0}, static_cast<std::uint32_t>(leaves.size())});
+    leaves.push_back(std::move(copy));
+    nodes[node].children = {first, first + 1};
+
+    if (records / 2 > threshold) {
+        split(first, records / 2, threshold, depth + 1);
+        split(first + 1, records / 2, threshold, depth + 1);
+    }
+}
+
+void SDTree::refine(const std::size_t pass) {
+    const double threshold = spatialThreshold * std::sqrt(std::pow(2., static_cast<double>(pass)));
+
+    // the busy leaves are split, assuming their records are spread evenly
+    const std::size_t count = nodes.size();
+    std::vector<int> depths(count, 0);
+    for (std::size_t node = 0; node < count; node++) {
+        if (nodes[node].children[0] != 0) {
+            depths[nodes[node].children[0]] = depths[node] + 1;
+            depths[nodes[node].children[1]] = depths[node] + 1;
+            continue;
+        }
+
+        const auto records = static_cast<double>(leaves[nodes[node].leaf].building.count());
+        if (records > threshold) split(static_cast<std::uint32_t>(node), records, threshold, depths[node]);
+    }
+
+    for (Leaf &leaf : leaves) {
+        leaf.sampling = leaf.building;
+        leaf.building.refine(leaf.sampling, fluxThreshold, maxDirectionalDepth);
+    }
+}
@@ -0,0 +1,168 @@
+/*
+ * This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
+ * Copyright (c) 2025 PrISE-3D.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * --- ADDITIONAL PERMISSION UNDER GNU GPL VERSION 3 SECTION 7 ---
+ *
+ * If you modify this Program, or any covered work, by linking or
+ * combining it with the Intel Math Kernel Library (MKL) (or a modified
+ * version of that library), containing parts covered by the terms of
+ * the Intel Simplified Software License, the licensors of this
+ * Program grant you additional permission to convey the resulting work.
+ */
+
+#include "torch_aggregator.h"
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <stdexcept>
+#include <torch/script.h>
+
+// ============================================================================
+// TorchAggregator
+// ============================================================================
+
+TorchAggregator::TorchAggregator(const TorchAggregatorFactory &factory): factory(factory) {}
+
+Color TorchAggregator::aggregate() {
+    if (weights.size() != contributions.size())
+        factory.infer({this});
+
+    Color color(0, 0, 0);
+    double total_weight = 0.;
+
+    for (std::size_t i = 0; i < contributions.size(); i++) {
+        color += weights[i] * contributions[i];
+        total_weight += weights[i];
+    }
+
+    // a model discarding every sample falls back on the Monte Carlo estimate
+    if (total_weight <= 0.)
+        return MCSampleAggregator::aggregate();
+
+    return color / total_weight;
+}
+
+// ============================================================================
+// TorchAggregatorFactory
+// ============================================================================
+
+struct TorchAggregatorFactory::Model {
+    torch::jit::script::Module module;
+    std::atomic<bool> failed{false};  // set by the first failed inference, which alone is reported
+};
+
+TorchAggregatorFactory::TorchAggregatorFactory(const std::filesystem::path &path, const int numThreads):
+    model(std::make_unique<Model>()) {
+    model->module = torch::jit::load(path.string(), torch::Device(torch::kCPU));
+    model->module.eval();
+    at::set_num_threads(std::max(1, numThreads));
+
+    // a model answering with another shape would only fail once the render threads run
+    c10::InferenceMode inference;
+    const torch::Tensor features = torch::zeros({2, 3, 5}, torch::kFloat32);
+    const torch::Tensor mask = torch::ones({2, 3}, torch::kBool);
+    const auto output = model->module.forward({features, mask});
+
+    if (!output.isTensor() || output.toTensor().numel() != 6)
+        throw std::invalid_argument("the model does not return one weight per sample, [B, N]");
+}
+
+TorchAggregatorFactory::~TorchAggregatorFactory() = default;
+
+shared_ptr<SampleAggregator> TorchAggregatorFactory::create() {
+    return make_pixel_shared<TorchAggregator>(*this);
+}
+
+void TorchAggregatorFactory::prepare(const std::vector<std::shared_ptr<SampleAggregator>> &aggregators) {
+    std::vector<TorchAggregator *> batch;
+    batch.reserve(std::min(batchSize, aggregators.size()));
+
+    for (const auto &aggregator : aggregators) {
+        auto *torch_aggregator = dynamic_cast<TorchAggregator *>(aggregator.get());
+        if (torch_aggregator == nullptr) continue;
+
+        batch.push_back(torch_aggregator);
+        if (batch.size() >= batchSize) {
+            infer(batch);
+            batch.clear();
+        }
+    }
+
+    if (!batch.empty())
+        infer(batch);
+}
+
+void TorchAggregatorFactory::infer(const std::vector<TorchAggregator *> &batch) const {
+    std::size_t max_count = 0;
+    for (const TorchAggregator *aggregator : batch)
+        max_count = std::max(max_count, aggregator->contributions.size());
+
+    if (max_count == 0) {
+        for (TorchAggregator *aggregator : batch) aggregator->weights.clear();
+        return;
+    }
+
+    const auto pixels = static_cast<int64_t>(batch.size());
+    const auto samples = static_cast<int64_t>(max_count);
+
+    c10::InferenceMode inference;
+
+    torch::Tensor features = torch::zeros({pixels, samples, 5}, torch::kFloat32);
+    torch::Tensor mask = torch::zeros({pixels, samples}, torch::kBool);
+    auto f = features.accessor<float, 3>();
+    auto m = mask.accessor<bool, 2>();
+
+    for (int64_t p = 0; p < pixels; p++) {
+        const TorchAggregator &aggregator = *batch[p];
+        int64_t s = 0;
+
+        for (const Sample &sample : aggregator) {
+            const Color &c = aggregator.contributions[s];
+            f[p][s][0] = static_cast<float>(sample.dx);
+            f[p][s][1] = static_cast<float>(sample.dy);
+            f[p][s][2] = static_cast<float>(c.x());
+            f[p][s][3] = static_cast<float>(c.y());
+            f[p][s][4] = static_cast<float>(c.z());
+            m[p][s] = true;
+            ++s;
+        }
+    }
+
+    torch::Tensor weights;
+    try {
+        weights = model->module.forward({features, mask}).toTensor()
+                      .to(torch::kFloat64).reshape({pixels, samples}).contiguous();
+    } catch (const c10::Error &e) {
+        // the render threads cannot stop on an error: the pixels keep the Monte Carlo mean, as uniform weights
+        if (!model->failed.exchange(true))
+            std::cerr << "The aggregation model failed, the Monte Carlo mean is used instead: " << e.what()
+                      << std::endl;
+
+        for (TorchAggregator *aggregator : batch)
+            aggregator->weights.assign(aggregator->contributions.size(), 1.);
+        return;
+    }
+
+    const auto w = weights.accessor<double, 2>();
+
+    for (int64_t p = 0; p < pixels; p++) {
+        TorchAggregator &aggregator = *batch[p];
+        const std::size_t count = aggregator.contributions.size();
+
+        aggregator.weights.resize(count);
+        for (std::size_t s = 0; s < count; s++)
+            aggregator.weights[s] = w[p][static_cast<int64_t>(s)];
+    }
+}
@@ -0,0 +1,283 @@
+/*
+ * This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
+ * Copyright (c) 2025 PrISE-3D.
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * --- ADDITIONAL PERMISSION UNDER GNU GPL VERSION 3 SECTION 7 ---
+ *
+ * If you modify this Program, or any covered work, by linking or
+ * combining it with the Intel Math Kernel Library (MKL) (or a modified
+ * version of that library), containing parts covered by the terms of
+ * the Intel Simplified Software License, the licensors of this
+ * Program grant you additional permission to convey the resulting work.
+ */
+
+#include "wavefront.h"
+#include "material.h"
+#include "arena.h"
+#include <algorithm>
+#include <numeric>
+
+// ============================================================================
+// Buffers
+// ============================================================================
+
+void WavefrontCamera::PathStates::clear() {
+    rays.clear();
+    hits.clear();
+    throughputs.clear();
+    radiances.clear();
+    brdf_pdfs.clear();
+    depths.clear();
+    slots.clear();
+}
+
+void WavefrontCamera::PathStates::push(const Ray &ray, const std::size_t slot, const int depth) {
+    rays.push_back(ray);
+    hits.emplace_back();
+    throughputs.emplace_back(1, 1, 1);
+    radiances.emplace_back(0, 0, 0);
+    brdf_pdfs.push_back(0);
+    depths.push_back(depth);
+    slots.push_back(slot);
+}
+
+void WavefrontCamera::ShadowRays::clear() {
+    rays.clear();
+    factors.clear();
+    scattering_pdfs.clear();
+    paths.clear();
+}
+
+// ============================================================================
+// WavefrontCamera
+// ============================================================================
+
+void WavefrontCamera::render(const Hittable &world, const Hittable &lights) {
+    nee = samplingStrategy && samplingStrategy->uses_nee();
+    ForwardParallelCamera::render(world, lights);
+}
+
+void WavefrontCamera::render_line(const Hittable &world, const Hittable &lights, const size_t j) {
+    // the aggregators of the line are dropped before the arena is released
+    PixelArena::Scope scope;
+    std::vector<std::shared_ptr<SampleAggregator>> aggregators;
+    render_pixels(world, lights, j, 0, imageWidth, aggregators);
+}
+
+std::shared_ptr<SampleAggregator> WavefrontCamera::render_pixel(const Hittable &world, const Hittable &lights,
+                                                               const size_t row, const size_t column) {
+    nee = samplingStrategy && samplingStrategy->uses_nee();
+    std::vector<std::shared_ptr<SampleAggregator>> aggregators;
+    render_pixels(world, lights, row, column, column + 1, aggregators);
+    return aggregators.front();
+}
+
+void WavefrontCamera::render_pixels(const Hittable &world, const Hittable &lights, const size_t row,
+                                    const size_t first_column, const size_t end_column,
+                                    std::vector<std::shared_ptr<SampleAggregator>> &aggregators) {
+    // sample the pixels exactly as the forward cameras do
+    std::vector<std::size_t> first_slots;
+    std::size_t sample_count = 0;
+
+    for (size_t column = first_column; column < end_column; ++column) {
+        random_seed(combine(seed, row, column));
+        const auto aggregator = samplerAggregator->create();
+        aggregator->sample_from(pixelSamplerFactory, static_cast<double>(column), static_cast<double>(row));
+        aggregators.push_back(aggregator);
+        first_slots.push_back(sample_count);
+        sample_count += static_cast<std::size_t>(aggregator->end() - aggregator->begin());
+    }
+
+    std::vector<Color> results(sample_count);
+    std::vector<FirstHits> first_hits(records_first_hits() ? sample_count : 0);
+    PathStates paths;
+
+    // generate the camera paths, tracing them by streams of bounded size
+    for (std::size_t p = 0; p < aggregators.size(); ++p) {
+        std::size_t slot = first_slots[p];
+        for (const Sample &sample : *aggregators[p]) {
+            paths.push(get_ray(sample.x, sample.y), slot++, static_cast<int>(maxDepth));
+
+            if (paths.size() >= streamSize) {
+                trace(world, lights, paths, results, first_hits);
+                paths.clear();
+            }
+        }
+    }
+
+    if (paths.size() > 0)
+        trace(world, lights, paths, results, first_hits);
+
+    // accumulate the estimates in sample order
+    for (std::size_t p = 0; p < aggregators.size(); ++p) {
+        const auto &aggregator = aggregators[p];
+        const auto count = static_cast<std::size_t>(aggregator->end() - aggregator->begin());
+
+        for (std::size_t s = 0; s < count; ++s)
+            aggregator->insert_contribution(results[first_slots[p] + s]);
+
+        if (!first_hits.empty())
+            for (std::size_t s = 0; s < count; ++s)
+                aggregator->firstHits += first_hits[first_slots[p] + s];
+    }
+
+    samplerAggregator->prepare(aggregators);
+
+    for (std::size_t p = 0; p < aggregators.size(); ++p)
+        persist_pixel(row, first_column + p, *aggregators[p]);
+}
+
+void WavefrontCamera::trace(const Hittable &world, const Hittable &lights, PathStates &paths,
+                            std::vector<Color> &results, std::vector<FirstHits> &first_hits) const {
+    std::vector<std::size_t> active(paths.size());
+    std::iota(active.begin(), active.end(), 0);
+
+    std::vector<std::size_t> next;
+    next.reserve(active.size());
+    ShadowRays shadows;
+    ScatterRecord scatterRecord;
+
+    while (!active.empty()) {
+        // INTERSECT: closest hits of the active paths, escaped paths gather the background
+        next.clear();
+        for (const std::size_t i : active) {
+            if (paths.depths[i] <= 0)
+                continue;
+
+            HitRecord &rec = paths.hits[i];
+            rec = HitRecord();
+            const Ray &r = paths.rays[i];
+
+            if (!world.hit(r, Interval(0.001, infinity), rec)) {
+                paths.radiances[i] += paths.throughputs[i] * background;
+                continue;
+            }
+
+            rec.finalize(r);
+
+            // the paths are generated with every bounce left, the first hit of a sample is met at that depth
+            if (!first_hits.empty() && paths.depths[i] == static_cast<int>(maxDepth))
+                record_first_hit(first_hits[paths.slots[i]], r, rec);
+
+            // MIS weight of the BRDF sample that led here, now that the light it hits is known
+            if (paths.brdf_pdfs[i] > 0) {
+                const double light_pdf = rec.light_id >= 0 ? lights.pdfValue(r.origin(), r.direction(), rec) : 0;
+                const double light_pdf_2 = light_pdf * light_pdf;
+                const double brdf_pdf_2 = paths.brdf_pdfs[i] * paths.brdf_pdfs[i];
+                paths.throughputs[i] = paths.throughputs[i] * (brdf_pdf_2 / (light_pdf_2 + brdf_pdf_2));
+            }
+
+            next.push_back(i);
+        }
+        std::swap(active, next);
+
+        // group the paths by material so that shading runs the same code on the same data
+        std::stable_sort(active.begin(), active.end(), [&paths](const std::size_t a, const std::size_t b) {
+            return paths.hits[a].mat_id < paths.hits[b].mat_id;
+        });
+
+        // SHADE: emission, light samples and scattering
+        next.clear();
+        shadows.clear();
+        for (const std::size_t i : active) {
+            const HitRecord &rec = paths.hits[i];
+            const Ray r = paths.rays[i];
+            const Material *mat = rec.material();
+
+            paths.radiances[i] += paths.throughputs[i] * mat->emitted(r, rec, rec.u, rec.v, rec.p);
+
+            if (!mat->scatter(r, rec, scatterRecord))
+                continue;
+
+            paths.depths[i] -= 1;
+
+            if (scatterRecord.skip_pdf) {
+                paths.throughputs[i] = paths.throughputs[i] * scatterRecord.attenuation;
+                paths.rays[i] = scatterRecord.skip_pdf_ray;
+                paths.brdf_pdfs[i] = 0;
+                next.push_back(i);
+                continue;
+            }
+
+            if (nee) {
+                // next event estimation: the shadow ray is traced in its own stage
+                const Ray light_ray(rec.p, lights.random(rec.p));
+                const double scattering_pdf = mat->scattering_pdf(r, rec, light_ray);
+
+                shadows.rays.push_back(light_ray);
+                shadows.factors.push_back(paths.throughputs[i] * scatterRecord.attenuation * scattering_pdf);
+                shadows.scattering_pdfs.push_back(scattering_pdf);
+                shadows.paths.push_back(i);
+
+                // continue the path with a sample of the BRDF, weighted once its hit is known
+                const Ray scattered(rec.p, scatterRecord.pdf_ptr->generate());
+                const double brdf_pdf = scatterRecord.pdf_ptr->value(scattered.direction());
+
+                if (brdf_pdf <= 0)
+                    continue;
+
+                const double scatteringPdf = mat->scattering_pdf(r, rec, scattered);
+                paths.throughputs[i] = paths.throughputs[i] * scatterRecord.attenuation * scatteringPdf / brdf_pdf;
+                paths.rays[i] = scattered;
+                paths.brdf_pdfs[i] = brdf_pdf;
+            } else {
+                // mixture of light and BRDF sampling
+                const auto light_ptr = make_shared<HittablePDF>(lights, rec.p);
+                const MixturePDF p(light_ptr, scatterRecord.pdf_ptr);
+
+                const Ray scattered(rec.p, p.generate());
+                const double pdfValue = p.value(scattered.direction());
+                const double scatteringPdf = mat->scattering_pdf(r, rec, scattered);
+
+                paths.throughputs[i] = paths.throughputs[i] * scatterRecord.attenuation * scatteringPdf / pdfValue;
+                paths.rays[i] = scattered;
+                paths.brdf_pdfs[i] = 0;
+            }
+
+            next.push_back(i);
+        }
+        std::swap(active, next);
+
+        // SHADOW: visibility and emission of the sampled light points
+        for (std::size_t s = 0; s < shadows.size(); ++s) {
+            const Ray &light_ray = shadows.rays[s];
+            HitRecord light_rec;
+
+            if (!world.hit(light_ray, Interval(0.001, infinity), light_rec) || light_rec.t <= 0.9999)
+                continue;
+
+            light_rec.finalize(light_ray);
+            const Color light_emission = light_rec.material()->emitted(light_ray, light_rec,
+                                                                        light_rec.u, light_rec.v, light_rec.p);
+            if (light_emission.length2() <= 0)
+                continue;
+
+            const double light_pdf = lights.pdfValue(light_ray.origin(), light_ray.direction(), light_rec);
+            if (light_pdf <= 0)
+                continue;
+
+            // POWER HEURISTIC (beta = 2)
+            const double light_pdf_2 = light_pdf * light_pdf;
+            const double scattering_pdf_2 = shadows.scattering_pdfs[s] * shadows.scattering_pdfs[s];
+            const double weight_nee = light_pdf_2 / (light_pdf_2 + scattering_pdf_2);
+
+            const std::size_t i = shadows.paths[s];
+            paths.radiances[i] += weight_nee * shadows.factors[s] * light_emission / light_pdf;
+        }
+    }
+
+    // ACCUMULATE: hand the estimates back to their samples
+    for (std::size_t i = 0; i < paths.size(); ++i)
+        results[paths.slots[i]] = paths.radiances[i];
+}
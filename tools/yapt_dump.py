@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+#
+# This file is part of the YAPT distribution (https://github.com/prise-3d/yapt).
+# Copyright (c) 2025 PrISE-3D.
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, version 3.
+#
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+# General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+"""
+Reader of the sample dumps written by yapt dump=path (format described in include/sample_dump.h).
+
+    from yapt_dump import read_dump
+    for pixels, samples in read_dump("out.dump"):
+        ...
+
+pixels is a structured array (x, y, first, count), samples a structured array (dx, dy, r, g, b, weight); the
+samples of pixel i are samples[pixels["first"][i]:][:pixels["count"][i]]. Uncompressed dumps are memory mapped.
+"""
+
+import struct
+import sys
+import zlib
+
+import numpy as np
+
+PIXEL = np.dtype([("x", "<u4"), ("y", "<u4"), ("first", "<u4"), ("count", "<u4")])
+SAMPLE = np.dtype([("dx", "<f8"), ("dy", "<f8"), ("r", "<f4"), ("g", "<f4"), ("b", "<f4"), ("weight", "<f4")])
+
+FILE_HEADER = struct.Struct("<8sII")
+CHUNK_HEADER = struct.Struct("<4sIQQQ")
+
+
+def read_dump(path):
+    """Yields the (pixels, samples) arrays of each chunk of a dump"""
+    with open(path, "rb") as f:
+        magic, version, flags = FILE_HEADER.unpack(f.read(FILE_HEADER.size))
+        if magic != b"YAPTDUMP" or version != 1:
+            raise ValueError(f"{path} is not a yapt sample dump")
+        compressed = bool(flags & 1)
+
+        raw = None if compressed else np.memmap(path, dtype=np.uint8, mode="r")
+        offset = FILE_HEADER.size
+
+        while True:
+            f.seek(offset)
+            header = f.read(CHUNK_HEADER.size)
+            if len(header) < CHUNK_HEADER.size:
+                return
+            magic, pixel_count, sample_count, stored, raw_size = CHUNK_HEADER.unpack(header)
+            if magic != b"CHNK":
+                raise ValueError(f"corrupted chunk at offset {offset}")
+            payload_offset = offset + CHUNK_HEADER.size
+
+            if compressed:
+                payload = np.frombuffer(zlib.decompress(f.read(stored)), dtype=np.uint8)
+            else:
+                payload = raw[payload_offset:payload_offset + raw_size]
+
+            pixel_bytes = pixel_count * PIXEL.itemsize
+            pixels = payload[:pixel_bytes].view(PIXEL)
+            samples = payload[pixel_bytes:pixel_bytes + sample_count * SAMPLE.itemsize].view(SAMPLE)
+            yield pixels, samples
+
+            offset = payload_offset + stored
+
+
+def main():
+    pixels = samples = 0
+    for chunk_pixels, chunk_samples in read_dump(sys.argv[1]):
+        pixels += len(chunk_pixels)
+        samples += len(chunk_samples)
+    print(f"{pixels} pixels, {samples} samples")
+
+
+if __name__ == "__main__":
+    main()